@@ -98,6 +98,13 @@ export enum MaskType {
 
 ccenum(MaskType);
 
+// Keep in sync with AnalyticMaskShape in native RenderEntity.h
+const enum AnalyticMaskShape {
+    NONE = 0,
+    ELLIPSE = 1,
+    ROUNDED_RECT = 2,
+}
+
 const SEGMENTS_MIN = 3;
 const SEGMENTS_MAX = 10000;
 
@@ -168,6 +175,7 @@ export class Mask extends Component {
                 this.subComp!.renderEntity.setMaskMode(this._inverted ? MaskMode.MASK_INVERTED : MaskMode.MASK);
             }
         }
+        this._syncNativeMaskShape();
     }
 
     /**
@@ -189,6 +197,86 @@ export class Mask extends Component {
         if (JSB) {
             this.subComp!.renderEntity.setMaskMode(this._inverted ? MaskMode.MASK_INVERTED : MaskMode.MASK);
         }
+        this._syncNativeMaskShape();
+    }
+
+    /**
+     * @en
+     * Clip the children of a rect mask on the CPU instead of writing stencil,
+     * so that they can be batched with the content outside of the mask. Only works on native platforms.
+     * It falls back to stencil if the mask is rotated or the children are not made of simple sprites and labels.
+     * @zh
+     * 矩形遮罩直接在 CPU 上裁剪子节点的顶点，不再写入模板缓冲，使子节点可以与遮罩外的内容合批。仅原生平台有效。
+     * 遮罩旋转或子节点不是简单精灵和文本时，会退回到模板遮罩。
+     */
+    @visible(function (this: Mask) {
+        return this.type === MaskType.GRAPHICS_RECT;
+    })
+    @displayOrder(15)
+    @tooltip('Clip the children on the CPU instead of writing stencil, native only')
+    get geometricClip (): boolean {
+        return this._geometricClip;
+    }
+
+    set geometricClip (value) {
+        if (this._geometricClip === value) {
+            return;
+        }
+        this._geometricClip = value;
+        this._syncNativeMaskShape();
+    }
+
+    /**
+     * @en
+     * Evaluate the ellipse or the (rounded) rect of the mask in the fragment shader of the children instead of writing stencil,
+     * the edge is anti-aliased. Only works on native platforms, and the materials of the children have to define
+     * `USE_ANALYTIC_MASK` with the `analyticMaskRect` and `analyticMaskParams` properties.
+     * It falls back to stencil if the mask is rotated, nested in another analytic mask, or a child material doesn't support it.
+     * @zh
+     * 在子节点的片元着色器中计算椭圆或（圆角）矩形遮罩，不再写入模板缓冲，边缘带抗锯齿。仅原生平台有效，
+     * 子节点的材质需要支持 `USE_ANALYTIC_MASK` 宏以及 `analyticMaskRect` 和 `analyticMaskParams` 属性。
+     * 遮罩旋转、嵌套在另一个解析遮罩中或子节点材质不支持时，会退回到模板遮罩。
+     */
+    @visible(function (this: Mask) {
+        return this.type === MaskType.GRAPHICS_RECT || this.type === MaskType.GRAPHICS_ELLIPSE;
+    })
+    @displayOrder(16)
+    @tooltip('Mask the children in their fragment shader instead of writing stencil, native only')
+    get analyticMask (): boolean {
+        return this._analyticMask;
+    }
+
+    set analyticMask (value) {
+        if (this._analyticMask === value) {
+            return;
+        }
+        this._analyticMask = value;
+        this._syncNativeMaskShape();
+    }
+
+    /**
+     * @en
+     * The corner radius of a rect mask.
+     * @zh
+     * 矩形遮罩的圆角半径。
+     */
+    @visible(function (this: Mask) {
+        return this.type === MaskType.GRAPHICS_RECT;
+    })
+    @displayOrder(17)
+    @tooltip('The corner radius of the rect mask')
+    get cornerRadius (): number {
+        return this._cornerRadius;
+    }
+
+    set cornerRadius (value) {
+        value = Math.max(value, 0);
+        if (this._cornerRadius === value) {
+            return;
+        }
+        this._cornerRadius = value;
+        this._updateGraphics();
+        this._syncNativeMaskShape();
     }
 
     /**
@@ -292,6 +380,15 @@ export class Mask extends Component {
     @serializable
     protected _alphaThreshold = 0.1;
 
+    @serializable
+    protected _geometricClip = false;
+
+    @serializable
+    protected _analyticMask = false;
+
+    @serializable
+    protected _cornerRadius = 0;
+
     protected _sprite: Sprite | null = null;
     protected _graphics: Graphics | null = null;
 
@@ -305,6 +402,7 @@ export class Mask extends Component {
                 this.subComp.renderEntity.setMaskMode(this._inverted ? MaskMode.MASK_INVERTED : MaskMode.MASK);
             }
         }
+        this._syncNativeMaskShape();
     }
 
     public onEnable (): void {
@@ -369,6 +467,35 @@ export class Mask extends Component {
 
     protected _nodeStateChange (type: TransformBit): void {
         this._updateGraphics();
+        this._syncNativeMaskShape();
+    }
+
+    protected _syncNativeMaskShape (): void {
+        if (!JSB || !this.subComp) {
+            return;
+        }
+        const nativeEntity = this.subComp.renderEntity.nativeObj;
+        const isRect = this._type === MaskType.GRAPHICS_RECT;
+        if (!isRect && this._type !== MaskType.GRAPHICS_ELLIPSE) {
+            nativeEntity.clearGeometricClip();
+            nativeEntity.clearAnalyticMask();
+            return;
+        }
+
+        const uiTrans = this.node._getUITransformComp()!;
+        const size = uiTrans.contentSize;
+        const ap = uiTrans.anchorPoint;
+        const x = -size.width * ap.x;
+        const y = -size.height * ap.y;
+        if (this._geometricClip && isRect && !this._inverted && this._cornerRadius <= 0) {
+            nativeEntity.setGeometricClipRect(x, y, size.width, size.height);
+        } else if (this._analyticMask) {
+            const shape = isRect ? AnalyticMaskShape.ROUNDED_RECT : AnalyticMaskShape.ELLIPSE;
+            nativeEntity.setAnalyticMask(shape, x, y, size.width, size.height, isRect ? this._cornerRadius : 0);
+        } else {
+            nativeEntity.clearGeometricClip();
+            nativeEntity.clearAnalyticMask();
+        }
     }
 
     private _changeRenderType (): void {
@@ -423,7 +550,11 @@ export class Mask extends Component {
         const x = -width * ap.x;
         const y = -height * ap.y;
         if (this._type === MaskType.GRAPHICS_RECT) {
-            graphics.rect(x, y, width, height);
+            if (this._cornerRadius > 0) {
+                graphics.roundRect(x, y, width, height, this._cornerRadius);
+            } else {
+                graphics.rect(x, y, width, height);
+            }
         } else if (this._type === MaskType.GRAPHICS_ELLIPSE) {
             const center = new Vec3(x + width / 2, y + height / 2, 0);
             const radius = new Vec3(width / 2, height / 2, 0);
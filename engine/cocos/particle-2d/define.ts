@@ -98,3 +98,26 @@ export const PositionType = Enum({
      */
     GROUPED: 2,
 });
+
+/**
+ * @en How a particle system is simulated while it is outside of the view rect or fully transparent. Only applies to
+ * the native simulator, see particleManager2D.
+ * @zh 粒子系统在视口外或完全透明时的模拟方式，仅对原生模拟器生效，参见 particleManager2D。
+ */
+export const ParticleCulling = Enum({
+    /**
+     * @en Simulated every frame.
+     * @zh 每帧模拟。
+     */
+    NONE: 0,
+    /**
+     * @en Simulated every few frames with the time of the frames skipped.
+     * @zh 每隔几帧模拟一次，补上跳过的时间。
+     */
+    THROTTLE: 1,
+    /**
+     * @en Neither simulated nor drawn, optionally catching up on the time skipped when visible again.
+     * @zh 既不模拟也不绘制，可选择在重新可见时补上跳过的时间。
+     */
+    PAUSE: 2,
+});
@@ -27,6 +27,8 @@ import { MotionStreak } from './motion-streak-2d';
 import { MotionStreakAssemblerManager } from './motion-streak-2d-assembler';
 import { ParticleSystem2DAssembler } from './particle-system-2d-assembler';
 import { ParticleAsset } from './particle-asset';
+import { particleManager2D } from './particle-manager-2d';
+import { ParticleCulling } from './define';
 
 export {
     ParticleSystem2D,
@@ -34,4 +36,6 @@ export {
     MotionStreakAssemblerManager,
     ParticleSystem2DAssembler,
     ParticleAsset,
+    particleManager2D,
+    ParticleCulling,
 };
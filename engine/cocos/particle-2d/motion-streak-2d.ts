@@ -31,6 +31,7 @@ import type { IBatcher } from '../2d/renderer/i-batcher';
 import { Vec2 } from '../core';
 import type { RenderData } from '../2d/renderer/render-data';
 import { RenderEntityFillColorType } from '../2d/renderer/render-entity';
+import { getNativeEffectsBatcher2D } from './native-effects-2d';
 
 export class Point {
     public point = new Vec2();
@@ -104,6 +105,7 @@ export class MotionStreak extends UIRenderer {
 
     public set fadeTime (val) {
         this._fadeTime = val;
+        this._syncNativeStreak();
         this.reset();
     }
     /**
@@ -118,6 +120,7 @@ export class MotionStreak extends UIRenderer {
     }
     public set minSeg (val) {
         this._minSeg = val;
+        this._syncNativeStreak();
     }
     /**
      * @en The stroke's width.
@@ -131,6 +134,7 @@ export class MotionStreak extends UIRenderer {
     }
     public set stroke (val) {
         this._stroke = val;
+        this._syncNativeStreak();
     }
 
     /**
@@ -163,6 +167,10 @@ export class MotionStreak extends UIRenderer {
         this._fastMode = val;
     }
 
+    /**
+     * @en The living points, empty on native platforms where the points are kept by the engine.
+     * @zh 当前的拖尾点，原生平台上由引擎保存，此数组为空。
+     */
     public get points (): Point[] {
         return this._points;
     }
@@ -199,6 +207,7 @@ export class MotionStreak extends UIRenderer {
                 this._renderData.material = this.material;
                 if (JSB) {
                     this._renderData.renderDrawInfo.setVertexPositionInWorld(true);
+                    this._syncNativeStreak();
                 }
                 this._updateColor();
             }
@@ -226,7 +235,26 @@ export class MotionStreak extends UIRenderer {
      */
     public reset (): void {
         this._points.length = 0;
-        if (this._renderData) this._renderData.clear();
+        if (this._renderData) {
+            this._renderData.clear();
+            if (JSB) {
+                getNativeEffectsBatcher2D().resetMotionStreak(this._renderData.renderDrawInfo.nativeObj);
+            }
+        }
+    }
+
+    public destroyRenderData (): void {
+        if (JSB && this._renderData) {
+            getNativeEffectsBatcher2D().removeMotionStreak(this._renderData.renderDrawInfo.nativeObj);
+        }
+        super.destroyRenderData();
+    }
+
+    protected _syncNativeStreak (): void {
+        if (!JSB || !this._renderData) {
+            return;
+        }
+        getNativeEffectsBatcher2D().setMotionStreak(this._renderData.renderDrawInfo.nativeObj, this.node, this._fadeTime, this._minSeg, this._stroke);
     }
 
     public lateUpdate (dt: number): void {
@@ -0,0 +1,105 @@
+/*
+ Copyright (c) 2020-2023 Xiamen Yaji Software Co., Ltd.
+
+ https://www.cocos.com/
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+import type { Color, IColorLike, IVec2Like } from '../core';
+import type { Node } from '../scene-graph';
+import type { NativeRenderDrawInfo } from '../2d/renderer/native-2d';
+import { director } from '../game';
+
+/**
+ * cc::ParticleEmitterConfig2D, converted field by field from a plain object. The names and values are those of the
+ * ParticleSystem2D properties, angles in degrees.
+ */
+export interface NativeParticleEmitterConfig2D {
+    emitterMode: number;
+    positionType: number;
+    totalParticles: number;
+    emissionRate: number;
+    duration: number;
+    maxDeltaTime: number;
+    life: number;
+    lifeVar: number;
+    sourcePos: IVec2Like;
+    posVar: IVec2Like;
+    angle: number;
+    angleVar: number;
+    startColor: IColorLike;
+    startColorVar: IColorLike;
+    endColor: IColorLike;
+    endColorVar: IColorLike;
+    startSize: number;
+    startSizeVar: number;
+    endSize: number;
+    endSizeVar: number;
+    startSpin: number;
+    startSpinVar: number;
+    endSpin: number;
+    endSpinVar: number;
+    aspectRatio: number;
+    gravity: IVec2Like;
+    speed: number;
+    speedVar: number;
+    tangentialAccel: number;
+    tangentialAccelVar: number;
+    radialAccel: number;
+    radialAccelVar: number;
+    rotationIsDir: boolean;
+    startRadius: number;
+    startRadiusVar: number;
+    endRadius: number;
+    endRadiusVar: number;
+    rotatePerS: number;
+    rotatePerSVar: number;
+}
+
+/**
+ * The entry points of cc::Batcher2d for the 2D effects simulated in native under JSB, keyed by the native draw info
+ * of the render data of the component.
+ */
+export interface NativeEffectsBatcher2D {
+    setMotionStreak (drawInfo: NativeRenderDrawInfo, node: Node, fadeTime: number, minSeg: number, stroke: number): void;
+    updateMotionStreak (drawInfo: NativeRenderDrawInfo, dt: number, color: Color, opacity: number): void;
+    resetMotionStreak (drawInfo: NativeRenderDrawInfo): void;
+    removeMotionStreak (drawInfo: NativeRenderDrawInfo): void;
+
+    setParticleEmitter (drawInfo: NativeRenderDrawInfo, node: Node, config: NativeParticleEmitterConfig2D): void;
+    setParticleEmitterUVs (drawInfo: NativeRenderDrawInfo, uvs: number[]): void;
+    updateParticleEmitter (drawInfo: NativeRenderDrawInfo, dt: number, opacity: number): void;
+    resetParticleEmitter (drawInfo: NativeRenderDrawInfo): void;
+    stopParticleEmitter (drawInfo: NativeRenderDrawInfo): void;
+    pauseParticleEmitter (drawInfo: NativeRenderDrawInfo): void;
+    removeParticleEmitter (drawInfo: NativeRenderDrawInfo): void;
+    getParticleCount (drawInfo: NativeRenderDrawInfo): number;
+    isParticleEmitterActive (drawInfo: NativeRenderDrawInfo): boolean;
+    isParticleEmitterFinished (drawInfo: NativeRenderDrawInfo): boolean;
+    setParticleEmitterCulling (drawInfo: NativeRenderDrawInfo, culling: number, catchUp: boolean, priority: number): void;
+    setParticleViewRect (left: number, bottom: number, right: number, top: number): void;
+    clearParticleViewRect (): void;
+    setMaxParticles (maxParticles: number): void;
+    printParticleStats (): void;
+}
+
+export function getNativeEffectsBatcher2D (): NativeEffectsBatcher2D {
+    return director.root!.batcher2D.nativeObj as unknown as NativeEffectsBatcher2D;
+}
@@ -0,0 +1,63 @@
+/*
+ Copyright (c) 2020-2023 Xiamen Yaji Software Co., Ltd.
+
+ https://www.cocos.com/
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+*/
+
+import { JSB } from 'internal:constants';
+import { getNativeEffectsBatcher2D } from './native-effects-2d';
+
+/**
+ * @en The budget and culling shared by the particle systems simulated in native under JSB: emitters outside of the
+ * view rect or fully transparent are throttled or paused as their culling says, and the emission of the lowest
+ * priorities is scaled down until the particles of all systems fit the budget. Does nothing on other platforms.
+ * @zh 原生平台上所有粒子系统共享的预算与剔除：视口外或完全透明的粒子系统按其剔除方式降频或暂停，
+ * 超出粒子预算时按优先级从低到高降低发射速率。其他平台上不生效。
+ */
+export const particleManager2D = {
+    /**
+     * @en The visible world rect, e.g. of the 2D camera, to be set again as the camera moves.
+     * @zh 可见的世界坐标矩形，例如 2D 相机的视口，相机移动时需重新设置。
+     */
+    setViewRect (left: number, bottom: number, right: number, top: number): void {
+        if (JSB) getNativeEffectsBatcher2D().setParticleViewRect(left, bottom, right, top);
+    },
+
+    clearViewRect (): void {
+        if (JSB) getNativeEffectsBatcher2D().clearParticleViewRect();
+    },
+
+    /**
+     * @en The most particles of all systems together, 0 for no limit. Live particles are never killed.
+     * @zh 所有粒子系统的粒子总数上限，0 表示不限制。已存在的粒子不会被移除。
+     */
+    setMaxParticles (maxParticles: number): void {
+        if (JSB) getNativeEffectsBatcher2D().setMaxParticles(maxParticles);
+    },
+
+    /**
+     * @en Logs the totals and the simulation cost of each system, most expensive first.
+     * @zh 输出粒子总数以及每个粒子系统的模拟耗时，按耗时从高到低排列。
+     */
+    printStats (): void {
+        if (JSB) getNativeEffectsBatcher2D().printParticleStats();
+    },
+};
@@ -22,12 +22,14 @@
  THE SOFTWARE.
 */
 
+import { JSB } from 'internal:constants';
 import { Vec2, Color, js, random, IColorLike, Vec4, clamp, toRadian, toDegree } from '../core';
 import { vfmtPosUvColor, getComponentPerVertex } from '../2d/renderer/vertex-format';
 import { PositionType, EmitterMode, START_SIZE_EQUAL_TO_END_SIZE, START_RADIUS_EQUAL_TO_END_RADIUS } from './define';
 import type { ParticleSystem2D } from './particle-system-2d';
 import type { MeshRenderData } from '../2d/renderer/render-data';
 import type { Particle2DAssembler } from './particle-system-2d-assembler';
+import { getNativeEffectsBatcher2D, NativeParticleEmitterConfig2D } from './native-effects-2d';
 
 const _pos = new Vec2();
 const _tpa = new Vec2();
@@ -37,6 +39,9 @@ const _col = new Vec4();
 
 const formatBytes = getComponentPerVertex(vfmtPosUvColor);
 
+// sent to the native simulator under JSB, the colors and vectors are the ones of the system
+const _nativeConfig = {} as NativeParticleEmitterConfig2D;
+
 // In the Free mode to get emit real rotation in the world coordinate.
 function getWorldRotation (node): number {
     let rotation = 0;
@@ -130,6 +135,9 @@ export class Simulator {
         this.readyToPlay = false;
         this.elapsed = this.sys.duration;
         this.emitCounter = 0;
+        if (JSB && this.renderData) {
+            getNativeEffectsBatcher2D().stopParticleEmitter(this.renderData.renderDrawInfo.nativeObj);
+        }
     }
 
     public reset (): void {
@@ -142,6 +150,81 @@ export class Simulator {
         for (let id = 0; id < particles.length; ++id) pool.put(particles[id]);
         particles.length = 0;
         if (this.renderData) this.renderData.resize(0, 0);
+        if (JSB && this.renderData) {
+            this.syncNative();
+            getNativeEffectsBatcher2D().resetParticleEmitter(this.renderData.renderDrawInfo.nativeObj);
+        }
+    }
+
+    public get particleCount (): number {
+        if (JSB && this.renderData) {
+            return getNativeEffectsBatcher2D().getParticleCount(this.renderData.renderDrawInfo.nativeObj);
+        }
+        return this.particles.length;
+    }
+
+    // Under JSB the particles are simulated by the native ParticleSimulator2D, which is given the properties of the
+    // system here and on each reset.
+    public syncNative (): void {
+        const renderData = this.renderData;
+        if (!JSB || !renderData) return;
+        const psys = this.sys;
+        const config = _nativeConfig;
+        config.emitterMode = psys.emitterMode;
+        config.positionType = psys.positionType;
+        config.totalParticles = psys.totalParticles;
+        config.emissionRate = psys.emissionRate;
+        config.duration = psys.duration;
+        config.maxDeltaTime = (psys.assembler as Particle2DAssembler).maxParticleDeltaTime;
+        config.life = psys.life;
+        config.lifeVar = psys.lifeVar;
+        config.sourcePos = psys.sourcePos;
+        config.posVar = psys.posVar;
+        config.angle = psys.angle;
+        config.angleVar = psys.angleVar;
+        config.startColor = psys.startColor;
+        config.startColorVar = psys.startColorVar;
+        config.endColor = psys.endColor;
+        config.endColorVar = psys.endColorVar;
+        config.startSize = psys.startSize;
+        config.startSizeVar = psys.startSizeVar;
+        config.endSize = psys.endSize;
+        config.endSizeVar = psys.endSizeVar;
+        config.startSpin = psys.startSpin;
+        config.startSpinVar = psys.startSpinVar;
+        config.endSpin = psys.endSpin;
+        config.endSpinVar = psys.endSpinVar;
+        config.aspectRatio = psys.aspectRatio || 1;
+        config.gravity = psys.gravity;
+        config.speed = psys.speed;
+        config.speedVar = psys.speedVar;
+        config.tangentialAccel = psys.tangentialAccel;
+        config.tangentialAccelVar = psys.tangentialAccelVar;
+        config.radialAccel = psys.radialAccel;
+        config.radialAccelVar = psys.radialAccelVar;
+        config.rotationIsDir = psys.rotationIsDir;
+        config.startRadius = psys.startRadius;
+        config.startRadiusVar = psys.startRadiusVar;
+        config.endRadius = psys.endRadius;
+        config.endRadiusVar = psys.endRadiusVar;
+        config.rotatePerS = psys.rotatePerS;
+        config.rotatePerSVar = psys.rotatePerSVar;
+        const batcher = getNativeEffectsBatcher2D();
+        batcher.setParticleEmitter(renderData.renderDrawInfo.nativeObj, psys.node, config);
+        batcher.setParticleEmitterCulling(renderData.renderDrawInfo.nativeObj, psys.culling, psys.catchUp, psys.priority);
+        this.updateUVs(true);
+    }
+
+    public pauseNative (): void {
+        if (JSB && this.renderData) {
+            getNativeEffectsBatcher2D().pauseParticleEmitter(this.renderData.renderDrawInfo.nativeObj);
+        }
+    }
+
+    public removeNative (): void {
+        if (JSB && this.renderData) {
+            getNativeEffectsBatcher2D().removeParticleEmitter(this.renderData.renderDrawInfo.nativeObj);
+        }
     }
 
     public emitParticle (pos): void {
@@ -234,6 +317,12 @@ export class Simulator {
 
     public updateUVs (force?: boolean): void {
         const renderData = this.renderData;
+        if (JSB) {
+            if (renderData && this.sys._renderSpriteFrame) {
+                getNativeEffectsBatcher2D().setParticleEmitterUVs(renderData.renderDrawInfo.nativeObj, this.sys._renderSpriteFrame.uv);
+            }
+            return;
+        }
         if (renderData && this.sys._renderSpriteFrame) {
             const vbuf = renderData.vData;
             const uv = this.sys._renderSpriteFrame.uv;
@@ -330,6 +419,10 @@ export class Simulator {
     }
 
     public step (dt: number): void {
+        if (JSB) {
+            this.stepNative(dt);
+            return;
+        }
         const assembler = this.sys.assembler as Particle2DAssembler;
         const psys = this.sys;
         const node = psys.node;
@@ -479,6 +572,28 @@ export class Simulator {
         }
     }
 
+    // The native simulator is stepped with the other emitters by the batcher, after this frame's update; its stop at
+    // the end of the duration and its finish are seen here one frame later.
+    private stepNative (dt: number): void {
+        const renderData = this.renderData;
+        if (!renderData) return;
+        const psys = this.sys;
+        const batcher = getNativeEffectsBatcher2D();
+        const drawInfo = renderData.renderDrawInfo.nativeObj;
+        if (batcher.isParticleEmitterFinished(drawInfo)) {
+            this.finished = true;
+            psys._finishedSimulation();
+            return;
+        }
+        if (this.active && !batcher.isParticleEmitterActive(drawInfo)) {
+            psys.stopSystem();
+        }
+        renderData.material = psys.getRenderMaterial(0); // hack
+        renderData.frame = psys._renderSpriteFrame; // hack
+        renderData.setRenderDrawInfoAttributes();
+        batcher.updateParticleEmitter(drawInfo, dt, psys.node._uiProps.opacity);
+    }
+
     requestData (vertexCount: number, indexCount: number): void {
         if (!this.renderData) return;
         let offset = this.renderData.indexCount;
@@ -40,7 +40,7 @@ import { tiffReader } from './tiff-reader';
 import codec from '../../external/compression/ZipUtils';
 import type { IBatcher } from '../2d/renderer/i-batcher';
 import { assetManager, builtinResMgr } from '../asset/asset-manager';
-import { PositionType, EmitterMode, DURATION_INFINITY, START_RADIUS_EQUAL_TO_END_RADIUS, START_SIZE_EQUAL_TO_END_SIZE } from './define';
+import { PositionType, EmitterMode, ParticleCulling, DURATION_INFINITY, START_RADIUS_EQUAL_TO_END_RADIUS, START_SIZE_EQUAL_TO_END_SIZE } from './define';
 import { ccwindow } from '../core/global-exports';
 import type { IAssembler, MeshRenderData } from '../2d';
 import type { TextureBase } from '../asset/assets/texture-base';
@@ -258,7 +258,7 @@ export class ParticleSystem2D extends UIRenderer {
      * @readonly
      */
     public get particleCount (): number {
-        return this._simulator.particles.length;
+        return this._simulator.particleCount;
     }
 
     /**
@@ -273,6 +273,7 @@ export class ParticleSystem2D extends UIRenderer {
     public set totalParticles (value: number) {
         if (this._totalParticles === value) return;
         this._totalParticles = value;
+        this._simulator.syncNative();
     }
 
     /**
@@ -508,6 +509,48 @@ export class ParticleSystem2D extends UIRenderer {
         this._positionType = val;
         this._updateMaterial();
         this._updatePositionType();
+        this._simulator.syncNative();
+    }
+
+    /**
+     * @en How the system is simulated while outside of the view rect of particleManager2D or fully transparent. Only
+     * the native simulator culls.
+     * @zh 粒子系统在 particleManager2D 的视口外或完全透明时的模拟方式，仅原生模拟器生效。
+     */
+    @type(ParticleCulling)
+    public get culling (): number {
+        return this._culling;
+    }
+    public set culling (value: number) {
+        this._culling = value;
+        this._simulator.syncNative();
+    }
+
+    /**
+     * @en Whether a paused system simulates the time it was culled for, up to the longest particle life, once
+     * visible again.
+     * @zh 暂停的粒子系统重新可见时，是否补上被剔除的时间，最多为粒子的最长生命周期。
+     */
+    @editable
+    public get catchUp (): boolean {
+        return this._catchUp;
+    }
+    public set catchUp (value: boolean) {
+        this._catchUp = value;
+        this._simulator.syncNative();
+    }
+
+    /**
+     * @en Systems of a higher priority keep their emission when the particle budget of particleManager2D runs out.
+     * @zh 当 particleManager2D 的粒子预算不足时，优先级较高的粒子系统保持其发射速率。
+     */
+    @editable
+    public get priority (): number {
+        return this._priority;
+    }
+    public set priority (value: number) {
+        this._priority = value;
+        this._simulator.syncNative();
     }
 
     /**
@@ -741,6 +784,12 @@ export class ParticleSystem2D extends UIRenderer {
     private _endColorVar: Color = new Color(0, 0, 0, 0);
     @serializable
     private _positionType = PositionType.FREE;
+    @serializable
+    private _culling = ParticleCulling.NONE;
+    @serializable
+    private _catchUp = false;
+    @serializable
+    private _priority = 0;
 
     private _stopped = true;
     private declare _previewTimer: number | null;
@@ -760,6 +809,11 @@ export class ParticleSystem2D extends UIRenderer {
         this._updatePositionType();
     }
 
+    public onDisable (): void {
+        super.onDisable();
+        this._simulator.pauseNative();
+    }
+
     public onDestroy (): void {
         super.onDestroy();
 
@@ -838,6 +892,7 @@ export class ParticleSystem2D extends UIRenderer {
 
     public override destroyRenderData (): void {
         if (this._simulator.renderData) {
+            this._simulator.removeNative();
             const assembler = this._assembler;
             if (assembler && assembler.removeData) {
                 assembler.removeData(this._simulator.renderData);
@@ -861,6 +916,7 @@ export class ParticleSystem2D extends UIRenderer {
                 simulator.uvFilled = 0;
                 renderData.particleInitRenderDrawInfo(this.renderEntity); // Make sure renderEntity and renderData are both from simulator.
                 simulator.initDrawInfo();
+                simulator.syncNative();
             }
         }
     }
@@ -23,6 +23,9 @@
 ****************************************************************************/
 
 #include "2d/renderer/Batcher2d.h"
+#include "2d/renderer/MotionStreak2D.h"
+#include "2d/renderer/ParticleManager2D.h"
+#include "2d/renderer/RenderDrawInfoPool.h"
 #include "application/ApplicationManager.h"
 #include "base/Log.h"
 #include "base/TypeDef.h"
@@ -33,6 +36,7 @@
 #include "core/assets/Texture2D.h"
 #include "core/scene-graph/Scene.h"
 #include "editor-support/MiddlewareManager.h"
+#include "renderer/core/ProgramLib.h"
 #include "renderer/pipeline/Define.h"
 #include "scene/Pass.h"
 
@@ -42,6 +46,13 @@ namespace {
 
 const bool ENABLE_SORTING_2D = true;
 int32_t sorting2DCount{0};
+Batcher2d* aliveInstance{nullptr};
+
+// Contract with the 2d effects supporting analytic masks, see builtin-sprite.effect. The uniforms have to be listed
+// in the effect properties.
+const ccstd::string ANALYTIC_MASK_DEFINE{"USE_ANALYTIC_MASK"};
+const ccstd::string ANALYTIC_MASK_RECT{"analyticMaskRect"};
+const ccstd::string ANALYTIC_MASK_PARAMS{"analyticMaskParams"};
 
 CC_FORCE_INLINE void fillIndexBuffers(RenderDrawInfo* drawInfo) { // NOLINT(readability-convert-member-functions-to-static)
     uint16_t* ib = drawInfo->getIDataBuffer();
@@ -102,6 +113,202 @@ CC_FORCE_INLINE void fillColor(RenderEntity* entity, RenderDrawInfo* drawInfo) {
     }
 }
 
+// The texture id of the multi texture effect is encoded into the red channel.
+CC_FORCE_INLINE void fillTextureId(RenderDrawInfo* drawInfo, float textureIdColor) {
+    uint8_t stride = drawInfo->getStride();
+    uint32_t size = drawInfo->getVbCount() * stride;
+    float* vbBuffer = drawInfo->getVbBuffer();
+    for (uint32_t i = 0; i < size; i += stride) {
+        vbBuffer[i + 5] = textureIdColor;
+    }
+}
+
+void runVertexFillTask(const VertexFillTask& task) {
+    if (task.fillPosition) {
+        fillVertexBuffers(task.entity, task.drawInfo);
+    }
+    if (task.fillColor) {
+        fillColor(task.entity, task.drawInfo);
+    }
+    if (task.fillTextureId) {
+        fillTextureId(task.drawInfo, task.textureIdColor);
+    }
+}
+
+// Below this the vertex work isn't worth waking the workers.
+constexpr uint32_t PARALLEL_VERTEX_FILL_MIN_VERTICES = 8192;
+constexpr uint32_t VERTEX_FILL_TASKS_PER_CHUNK = 32;
+constexpr uint32_t MAX_BATCHER_WORKERS = 3;
+
+CC_FORCE_INLINE bool isAxisAligned(const Mat4& matrix) {
+    return math::isEqualF(matrix.m[1], 0.F) && math::isEqualF(matrix.m[4], 0.F) &&
+           math::isEqualF(matrix.m[3], 0.F) && math::isEqualF(matrix.m[7], 0.F);
+}
+
+// Quads laid out as sprites and glyphs are: lb, rb, lt, rt with indices 0, 1, 2, 1, 3, 2.
+CC_FORCE_INLINE bool isQuadList(const RenderDrawInfo* drawInfo) {
+    uint32_t vbCount = drawInfo->getVbCount();
+    return vbCount % 4 == 0 && drawInfo->getIbCount() == vbCount / 4 * 6;
+}
+
+// The clip writes into the uvs of the vertex buffer, the unclipped ones are kept in the cold data.
+CC_FORCE_INLINE void saveClipUVs(RenderDrawInfo* drawInfo) {
+    uint8_t stride = drawInfo->getStride();
+    uint32_t vbCount = drawInfo->getVbCount();
+    const float* vbBuffer = drawInfo->getVbBuffer();
+    auto* coldData = drawInfo->requireColdData();
+    auto& uvs = coldData->clipUVs;
+    uvs.resize(vbCount * 4);
+    for (uint32_t i = 0; i < vbCount; i++) {
+        const float* uv = vbBuffer + i * stride + 3;
+        uvs[i * 4] = uvs[i * 4 + 2] = uv[0];
+        uvs[i * 4 + 1] = uvs[i * 4 + 3] = uv[1];
+    }
+    coldData->vertexClipped = true;
+}
+
+// JS only writes the uvs which changed, the ones still holding what the clip wrote get the unclipped ones back.
+CC_FORCE_INLINE void restoreClipUVs(RenderDrawInfo* drawInfo) {
+    uint8_t stride = drawInfo->getStride();
+    float* vbBuffer = drawInfo->getVbBuffer();
+    auto* coldData = drawInfo->getColdData();
+    const auto& uvs = coldData->clipUVs;
+    const uint32_t vbCount = std::min(drawInfo->getVbCount(), static_cast<uint32_t>(uvs.size() / 4));
+    for (uint32_t i = 0; i < vbCount; i++) {
+        float* uv = vbBuffer + i * stride + 3;
+        if (uv[0] == uvs[i * 4 + 2] && uv[1] == uvs[i * 4 + 3]) { // NOLINT(clang-diagnostic-float-equal)
+            uv[0] = uvs[i * 4];
+            uv[1] = uvs[i * 4 + 1];
+        }
+    }
+    coldData->vertexClipped = false;
+}
+
+void addBatchesToScenes(const ccstd::vector<scene::DrawBatch2D*>& batches, const ccstd::vector<std::pair<scene::RenderScene*, size_t>>& sceneBatchRanges) {
+    size_t index = 0;
+    for (const auto& range : sceneBatchRanges) {
+        for (size_t i = index; i < range.second; i++) {
+            range.first->addBatch(batches.at(i));
+        }
+        index = range.second;
+    }
+}
+
+// Crop world space quads against the clip rect, quads fully outside emit no indices.
+void fillClippedIndexBuffers(RenderDrawInfo* drawInfo, const ClipRect& clip) {
+    uint16_t* ib = drawInfo->getIDataBuffer();
+
+    UIMeshBuffer* buffer = drawInfo->getMeshBuffer();
+    uint32_t indexOffset = buffer->getIndexOffset();
+
+    const uint16_t* indexb = drawInfo->getIbBuffer();
+    float* vbBuffer = drawInfo->getVbBuffer();
+    uint8_t stride = drawInfo->getStride();
+    uint32_t quadCount = drawInfo->getVbCount() / 4;
+
+    // per vertex: u, v before the clip, u, v written by the clip, see saveClipUVs
+    float* clipUVs = drawInfo->getColdData()->clipUVs.data();
+
+    for (uint32_t q = 0; q < quadCount; q++) {
+        uint32_t quadOffset = q * 4 * stride;
+        float* verts[4] = {vbBuffer + quadOffset, vbBuffer + quadOffset + stride, vbBuffer + quadOffset + 2 * stride, vbBuffer + quadOffset + 3 * stride};
+        float* uvs[4] = {clipUVs + q * 16, clipUVs + q * 16 + 4, clipUVs + q * 16 + 8, clipUVs + q * 16 + 12};
+
+        const float x0 = verts[0][0];
+        const float x1 = verts[1][0];
+        const float y0 = verts[0][1];
+        const float y2 = verts[2][1];
+        const float minX = std::min(x0, x1);
+        const float maxX = std::max(x0, x1);
+        const float minY = std::min(y0, y2);
+        const float maxY = std::max(y0, y2);
+        if (maxX <= clip.left || minX >= clip.right || maxY <= clip.bottom || minY >= clip.top || minX == maxX || minY == maxY) {
+            continue;
+        }
+
+        if (minX >= clip.left && maxX <= clip.right && minY >= clip.bottom && maxY <= clip.top) {
+            // the vertex buffer still holds the unclipped uvs
+        } else {
+            const float dx = x1 - x0;
+            const float dy = y2 - y0;
+            for (uint32_t k = 0; k < 4; k++) {
+                const float x = std::min(std::max(verts[k][0], clip.left), clip.right);
+                const float y = std::min(std::max(verts[k][1], clip.bottom), clip.top);
+                const float s = (x - x0) / dx;
+                const float t = (y - y0) / dy;
+                // bilinear, so rotated sprite frames keep their uv orientation
+                const float bottomU = uvs[0][0] + (uvs[1][0] - uvs[0][0]) * s;
+                const float bottomV = uvs[0][1] + (uvs[1][1] - uvs[0][1]) * s;
+                const float topU = uvs[2][0] + (uvs[3][0] - uvs[2][0]) * s;
+                const float topV = uvs[2][1] + (uvs[3][1] - uvs[2][1]) * s;
+                verts[k][0] = x;
+                verts[k][1] = y;
+                verts[k][3] = bottomU + (topU - bottomU) * t;
+                verts[k][4] = bottomV + (topV - bottomV) * t;
+            }
+            for (uint32_t k = 0; k < 4; k++) {
+                uvs[k][2] = verts[k][3];
+                uvs[k][3] = verts[k][4];
+            }
+        }
+
+        memcpy(&ib[indexOffset], indexb + q * 6, 6 * sizeof(uint16_t));
+        indexOffset += 6;
+    }
+
+    buffer->setIndexOffset(indexOffset);
+}
+
+// indices are 16 bits
+constexpr uint32_t MAX_MIDDLEWARE_BATCH_VERTICES = 65535;
+constexpr uint32_t MIN_MIDDLEWARE_BATCH_VERTICES = 1024;
+constexpr uint32_t LOCAL_UBO_PAGE_SLOTS = 64;
+
+bool isMultMaterial(Material* material) {
+    return material != nullptr && material->getEffectName().find("Mult-effect") != std::string::npos;
+}
+
+uint32_t getAttributesStride(const ccstd::vector<gfx::Attribute>& attrs) {
+    uint32_t stride = 0;
+    for (const auto& attr : attrs) {
+        stride += gfx::GFX_FORMAT_INFOS[static_cast<uint32_t>(attr.format)].size;
+    }
+    return stride;
+}
+
+ccstd::hash_t getAttributesHash(const ccstd::vector<gfx::Attribute>& attrs) {
+    ccstd::hash_t hash = 0;
+    for (const auto& attr : attrs) {
+        ccstd::hash_combine(hash, attr.name);
+        ccstd::hash_combine(hash, static_cast<uint32_t>(attr.format));
+    }
+    return hash;
+}
+
+// The texture slot of multi textured draws is encoded into the red channel, which needs a float color after uv.
+bool hasFloatColor(const ccstd::vector<gfx::Attribute>& attrs) {
+    uint32_t offset = 0;
+    for (const auto& attr : attrs) {
+        if (attr.name == gfx::ATTR_NAME_COLOR) {
+            return attr.format == gfx::Format::RGBA32F && offset == 5 * sizeof(float);
+        }
+        offset += gfx::GFX_FORMAT_INFOS[static_cast<uint32_t>(attr.format)].size;
+    }
+    return false;
+}
+
+void getIndexedVertexRange(UIMeshBuffer* meshBuffer, uint32_t indexOffset, uint32_t indexCount, uint32_t* vertexStart, uint32_t* vertexEnd) {
+    const uint16_t* iData = meshBuffer->getIData() + indexOffset;
+    uint32_t minIndex = UINT16_MAX;
+    uint32_t maxIndex = 0;
+    for (uint32_t i = 0; i < indexCount; i++) {
+        minIndex = std::min(minIndex, static_cast<uint32_t>(iData[i]));
+        maxIndex = std::max(maxIndex, static_cast<uint32_t>(iData[i]));
+    }
+    *vertexStart = indexCount == 0 ? 0 : minIndex;
+    *vertexEnd = indexCount == 0 ? 0 : maxIndex + 1;
+}
+
 } // namespace
 
 uint32_t g_count = 0;
@@ -134,12 +341,12 @@ Texture2D* getDefultTexture() {
     return g_texture;
 }
 
-void filltexture() {
-    if (g_currMaterial) {
+void filltexture(Material* material, uint32_t count) {
+    if (material) {
         auto t = getDefultTexture();
-        for (int i = g_count; i < 8; i++) {
+        for (uint32_t i = count; i < 8; i++) {
             ccstd::string name = "texture" + std::to_string(i);
-            const auto& pass = g_currMaterial->getPasses()->at(0);
+            const auto& pass = material->getPasses()->at(0);
             uint32_t handle = pass->getHandle(name);
 
             uint32_t binding = scene::Pass::getBindingFromHandle(handle);
@@ -150,7 +357,7 @@ void filltexture() {
 }
 void g_mult_next() {
     g_textures.clear();
-    filltexture();
+    filltexture(g_currMaterial, g_count);
 
     g_currMaterial = nullptr;
     g_isMult = false;
@@ -183,14 +390,29 @@ Batcher2d::Batcher2d(Root* root)
     _recordedRendererInfoQueue.reserve(100);
 
     getDefultTexture();
+    aliveInstance = this;
     CC_LOG_WARNING("Batcher2d::Batcher2d");
 }
 
 Batcher2d::~Batcher2d() { // NOLINT
+    if (aliveInstance == this) {
+        aliveInstance = nullptr;
+    }
 
     g_mult_clear();
     CC_LOG_WARNING("Batcher2d::~Batcher2d");
 
+    CC_SAFE_DELETE(_workers);
+    // the draw infos may be released already, they aren't emptied
+    for (auto& pair : _motionStreaks) {
+        delete pair.second;
+    }
+    _motionStreaks.clear();
+    for (auto& pair : _particleEmitters) {
+        delete pair.second;
+    }
+    _particleEmitters.clear();
+
     _drawBatchPool.destroy();
 
     for (auto iter : _descriptorSetCache) {
@@ -198,8 +420,17 @@ Batcher2d::~Batcher2d() { // NOLINT
     }
 
     for (auto* drawBatch : _batches) {
+        if (isModelCacheBatch(drawBatch)) {
+            continue;
+        }
         delete drawBatch;
     }
+    for (auto& pair : _modelBatchCaches) {
+        releaseModelBatchCache(&pair.second);
+    }
+    _modelBatchCaches.clear();
+
+    _middlewareBatchBuffers.clear();
     _attributes.clear();
 
     if (_maskClearModel != nullptr) {
@@ -211,7 +442,11 @@ Batcher2d::~Batcher2d() { // NOLINT
         _maskModelMesh = nullptr;
     }
     _maskClearMtl = nullptr;
+    _maskClearNode = nullptr;
     _maskAttributes.clear();
+
+    RenderDrawInfoPool::destroyInstance();
+    ParticleManager2D::destroyInstance();
 }
 
 ccstd::vector<RecordedRendererInfo>& Batcher2d::getRecordedRendererInfoQueue() {
@@ -242,8 +477,23 @@ void Batcher2d::syncRootNodesToNative(ccstd::vector<Node*>&& rootNodes) {
 }
 
 void Batcher2d::fillBuffersAndMergeBatches() {
-    size_t index = 0;
+    walkRootNodes();
+    if (_refillFrame) {
+        // Content below a stencil free mask stopped supporting it, e.g. a child was rotated. The walk updated the
+        // state of the mask, so the frame is filled again with stencil. The queued vertex work is still valid.
+        discardFilledBatches();
+        walkRootNodes();
+        _refillFrame = false;
+    }
+    flushVertexFillTasks();
+    addBatchesToScenes(_batches, _sceneBatchRanges);
+}
+
+void Batcher2d::walkRootNodes() {
+    _sceneBatchRanges.clear();
     for (auto* rootNode : _rootNodeArr) {
+        _stencilManager->resetDirtyBits();
+        _stencilLayer = 0;
         // _batches will add by generateBatch
         walk(rootNode, 1, false);
 
@@ -253,16 +503,72 @@ void Batcher2d::fillBuffersAndMergeBatches() {
 
         generateBatch(_currEntity, _currDrawInfo);
 
-        auto* scene = rootNode->getScene()->getRenderScene();
-        size_t const count = _batches.size();
-        for (size_t i = index; i < count; i++) {
-            scene->addBatch(_batches.at(i));
+        _sceneBatchRanges.emplace_back(rootNode->getScene()->getRenderScene(), _batches.size());
+    }
+}
+
+// Drops everything filled in this frame but the vertex work, the render data walked again writes the same vertices.
+void Batcher2d::discardFilledBatches() {
+    releaseBatches();
+    _sceneBatchRanges.clear();
+    _meshRenderDrawInfo.clear();
+    for (auto& map : _meshBuffersMap) {
+        for (auto* buffer : map.second) {
+            if (buffer) {
+                buffer->setIndexOffset(0);
+            }
+        }
+    }
+    for (auto& pair : _middlewareBatchBuffers) {
+        for (auto& batchBuffer : pair.second.buffers) {
+            batchBuffer->vertexCount = 0;
+            batchBuffer->indexCount = 0;
+        }
+        pair.second.used = 0;
+    }
+    for (auto& pair : _analyticMaskMaterialPools) {
+        pair.second.used = 0;
+    }
+    for (auto& pair : _middlewareMultMaterialPools) {
+        pair.second.used = 0;
+    }
+    _stencilManager->resetDirtyBits();
+    _clipRectStack.clear();
+    _maskContentChecks.clear();
+    _analyticMaskEntity = nullptr;
+    _analyticMaskActiveMaterials.clear();
+    resetRenderStates();
+    g_mult_reset();
+    _currMeshBuffer = nullptr;
+    _indexStart = 0;
+    _currHash = 0;
+    _currStencilStage = StencilStage::DISABLED;
+}
+
+void Batcher2d::flushVertexFillTasks() {
+    if (_vertexFillTasks.empty()) {
+        return;
+    }
+    const auto job = [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            runVertexFillTask(_vertexFillTasks[i]);
         }
-        index = count;
+    };
+    const auto count = static_cast<uint32_t>(_vertexFillTasks.size());
+    if (_vertexFillCount >= PARALLEL_VERTEX_FILL_MIN_VERTICES) {
+        getWorkers()->parallelFor(count, VERTEX_FILL_TASKS_PER_CHUNK, job);
+    } else {
+        job(0, count);
     }
+    _vertexFillTasks.clear();
+    _vertexFillCount = 0;
 }
 
 void Batcher2d::handleUIRenderer(RenderEntity* entity) { // NOLINT(misc-no-recursion)
+    if (isStencilFreeMask(entity)) {
+        // The mask shape is applied to the children, nothing to draw into stencil.
+        return;
+    }
     uint32_t size = entity->getRenderDrawInfosSize();
     for (uint32_t i = 0; i < size; i++) {
         auto* drawInfo = entity->getRenderDrawInfoAt(i);
@@ -316,6 +622,10 @@ void Batcher2d::walk(Node* node, float parentOpacity, bool parentColorDirty) { /
         if (!visible) {
             breakWalk = true;
         } else if (entity->isEnabled()) {
+            if (!_maskContentChecks.empty() && !entity->getIsMask()) {
+                // nested masks only write stencil, their content is checked below
+                checkMaskContent(entity, node);
+            }
             if (isCurrentColorDirty) {
                 entity->setOpacity(finalOpacity);
                 entity->setVBColorDirty(true);
@@ -325,11 +635,16 @@ void Batcher2d::walk(Node* node, float parentOpacity, bool parentColorDirty) { /
                 if (entity->getIsMask()) {
                     flushRecordedUIRenderers();
 
-                    generateBatch(_currEntity, _currDrawInfo);
-                    resetRenderStates();
+                    if (!enterStencilFreeMask(entity)) {
+                        generateBatch(_currEntity, _currDrawInfo);
+                        resetRenderStates();
+                    }
                 }
                 recordUIRenderer(entity);
             } else {
+                if (entity->getIsMask()) {
+                    enterStencilFreeMask(entity);
+                }
                 handleUIRenderer(entity);
             }
         }
@@ -360,7 +675,9 @@ void Batcher2d::walk(Node* node, float parentOpacity, bool parentColorDirty) { /
             }
         }
 
-        if (visible && _stencilManager->getMaskStackSize() > 0) {
+        if (visible && entity->getIsMask() && exitStencilFreeMask(entity)) {
+            // Never entered a stencil level.
+        } else if (visible && _stencilManager->getMaskStackSize() > 0) {
             handlePostRender(entity);
         }
     }
@@ -397,6 +714,12 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
     auto tex = drawInfo->getTexture();
     auto mat = drawInfo->getMaterial();
 
+    // back to the unclipped uvs before they are clipped again
+    const bool wasClipped = drawInfo->isVertexClipped();
+    if (wasClipped) {
+        restoreClipUVs(drawInfo);
+    }
+
     if (tex && mat && mat->getEffectName().find("Mult-effect") != std::string::npos) {
         isMult = true;
         auto iter = g_textures.find(tex);
@@ -407,6 +730,8 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
         }
 
         if (g_isMult) mat = _currMaterial;
+    } else if (_analyticMaskEntity != nullptr && supportsAnalyticMask(mat)) {
+        mat = getAnalyticMaskMaterial(mat);
     }
 
     if (isFlush || _currHash != dataHash || dataHash == 0 || _currMaterial != mat || _currStencilStage != tempStage) {
@@ -439,7 +764,7 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
             g_currMaterial = _currMaterial;
 
         } else
-            _currMaterial = drawInfo->getMaterial();
+            _currMaterial = mat;
 
         _currHash = dataHash;
         _currStencilStage = tempStage;
@@ -447,7 +772,7 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
         _currEntity = entity;
         _currDrawInfo = drawInfo;
 
-        _currTexture = drawInfo->getTexture();
+        _currTexture = tex;
         _currSampler = drawInfo->getSampler();
         if (_currSampler == nullptr) {
             _currSamplerHash = 0;
@@ -457,17 +782,28 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
     }
 
     if (!drawInfo->getIsMeshBuffer()) {
-        if (!drawInfo->isVertexPositionInWorld()) {
-            if (node->getChangedFlags() || node->isTransformDirty() || drawInfo->getVertDirty()) {
-                fillVertexBuffers(entity, drawInfo);
-                drawInfo->setVertDirty(false);
+        const bool clipped = !_clipRectStack.empty();
+        // Unclipped draws write their own vertices only, that's left to the workers after the walk.
+        VertexFillTask task{entity, drawInfo};
+        if (clipped) {
+            // The clip depends on the mask transform too, so always refill from the local layout.
+            saveClipUVs(drawInfo);
+            fillVertexBuffers(entity, drawInfo);
+            drawInfo->setVertDirty(false);
+        } else {
+            if (!drawInfo->isVertexPositionInWorld()) {
+                // the clipped positions are replaced too
+                if (wasClipped || node->getChangedFlags() || node->isTransformDirty() || drawInfo->getVertDirty()) {
+                    task.fillPosition = true;
+                    drawInfo->setVertDirty(false);
+                }
             }
         }
 
         if (entity->getVBColorDirty()) {
             switch (entity->getFillColorType()) {
                 case FillColorType::COLOR: {
-                    fillColor(entity, drawInfo);
+                    task.fillColor = true;
                     break;
                 }
                 case FillColorType::VERTEX: {
@@ -479,7 +815,11 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
             }
         }
 
-        fillIndexBuffers(drawInfo);
+        if (clipped) {
+            fillClippedIndexBuffers(drawInfo, _clipRectStack.back().rect);
+        } else {
+            fillIndexBuffers(drawInfo);
+        }
 
         if (isMult) {
             if (texid < 0 || g_count == 0) {
@@ -491,22 +831,20 @@ CC_FORCE_INLINE void Batcher2d::handleComponentDraw(RenderEntity* entity, Render
 
                 // _currMaterial->setProperty(name,drawInfo->getTexture(),0);
                 uint32_t binding = scene::Pass::getBindingFromHandle(handle);
-                pass->bindTexture(binding, drawInfo->getTexture(), 0);
+                pass->bindTexture(binding, tex, 0);
                 pass->bindSampler(binding, drawInfo->getSampler(), 0);
             }
 
             Color temp = entity->getColor();
-            // float opacity = entity->getOpacity();
-            uint8_t stride = drawInfo->getStride();
-            float* vbBuffer = drawInfo->getVbBuffer();
-            uint32_t size = drawInfo->getVbCount() * stride;
-
-            // uint32_t offset = 0;
-            auto newid = floor((static_cast<float>(temp.r) / 255.0F) * 100000) * 10 + texid;
-            for (int i = 0; i < size; i += stride) {
-                // offset = i + 5;
-                vbBuffer[i + 5] = newid;
-            }
+            task.fillTextureId = true;
+            task.textureIdColor = floor((static_cast<float>(temp.r) / 255.0F) * 100000) * 10 + texid;
+        }
+
+        if (clipped) {
+            runVertexFillTask(task);
+        } else if (task.fillPosition || task.fillColor || task.fillTextureId) {
+            _vertexFillTasks.push_back(task);
+            _vertexFillCount += drawInfo->getVbCount();
         }
     }
 
@@ -540,48 +878,194 @@ CC_FORCE_INLINE void Batcher2d::handleModelDraw(RenderEntity* entity, RenderDraw
     auto* model = drawInfo->getModel();
     if (model == nullptr) return;
     auto stamp = CC_CURRENT_ENGINE()->getTotalFrames();
-    model->updateTransform(stamp);
-    model->updateUBOs(stamp);
+    auto layer = entity->getNode()->getLayer();
+    auto& cache = _modelBatchCaches[model];
 
+    // Model local UBOs only change with the transform, and the layer goes into the batch vis flags.
+    Node* transform = model->getTransform();
+    if (cache.batches.empty() || cache.layer != layer || transform == nullptr || transform->getChangedFlags() || transform->isTransformDirty()) {
+        model->updateTransform(stamp);
+        model->updateUBOs(stamp);
+    }
+
+    if (isModelBatchCacheValid(cache, model, renderMat, dssHash, layer)) {
+        // fillPass isn't called for cached batches, upload the material uniforms instead.
+        for (const auto& pass : *renderMat->getPasses()) {
+            pass->update();
+        }
+    } else {
+        rebuildModelBatchCache(&cache, model, renderMat, depthStencil, dssHash, layer);
+    }
+    cache.used = true;
+    _batches.insert(_batches.end(), cache.batches.begin(), cache.batches.end());
+
+    if (isMask) {
+        _stencilManager->enableMask();
+    }
+}
+
+bool Batcher2d::isModelBatchCacheValid(const ModelBatchCache& cache, scene::Model* model, Material* material, ccstd::hash_t dssHash, uint32_t layer) const {
     const auto& subModelList = model->getSubModels();
-    for (const auto& submodel : subModelList) {
-        auto* curdrawBatch = _drawBatchPool.alloc();
-        curdrawBatch->setVisFlags(entity->getNode()->getLayer());
+    if (cache.model != model || cache.batches.size() != subModelList.size() || cache.material != material || cache.materialHash != material->getHash() || cache.dssHash != dssHash || cache.layer != layer) {
+        return false;
+    }
+    for (size_t i = 0; i < subModelList.size(); i++) {
+        const auto* batch = cache.batches[i];
+        const auto& submodel = subModelList[i];
+        if (batch->getModel() != model || batch->getInputAssembler() != submodel->getInputAssembler() || batch->getDescriptorSet() != submodel->getDescriptorSet()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Batcher2d::rebuildModelBatchCache(ModelBatchCache* cache, scene::Model* model, Material* material, gfx::DepthStencilState* depthStencil, ccstd::hash_t dssHash, uint32_t layer) {
+    const auto& subModelList = model->getSubModels();
+    while (cache->batches.size() > subModelList.size()) {
+        delete cache->batches.back();
+        cache->batches.pop_back();
+    }
+    while (cache->batches.size() < subModelList.size()) {
+        cache->batches.push_back(ccnew scene::DrawBatch2D());
+    }
+
+    for (size_t i = 0; i < subModelList.size(); i++) {
+        auto* curdrawBatch = cache->batches[i];
+        const auto& submodel = subModelList[i];
+        curdrawBatch->clear();
+        curdrawBatch->setVisFlags(layer);
         curdrawBatch->setModel(model);
         curdrawBatch->setInputAssembler(submodel->getInputAssembler());
         curdrawBatch->setDescriptorSet(submodel->getDescriptorSet());
 
-        curdrawBatch->fillPass(renderMat, depthStencil, dssHash, &(submodel->getPatches()));
-        _batches.push_back(curdrawBatch);
+        curdrawBatch->fillPass(material, depthStencil, dssHash, &(submodel->getPatches()));
     }
 
-    if (isMask) {
-        _stencilManager->enableMask();
+    cache->model = model;
+    cache->material = material;
+    cache->materialHash = material->getHash();
+    cache->dssHash = dssHash;
+    cache->layer = layer;
+}
+
+void Batcher2d::releaseModelBatchCache(ModelBatchCache* cache) { // NOLINT(readability-convert-member-functions-to-static)
+    for (auto* batch : cache->batches) {
+        batch->clear();
+        delete batch;
     }
+    cache->batches.clear();
+}
+
+bool Batcher2d::isModelCacheBatch(scene::DrawBatch2D* batch) const {
+    auto* model = batch->getModel();
+    return model != nullptr && _modelBatchCaches.find(model) != _modelBatchCaches.end();
 }
 
 CC_FORCE_INLINE void Batcher2d::handleMiddlewareDraw(RenderEntity* entity, RenderDrawInfo* drawInfo) {
-    auto layer = entity->getNode()->getLayer();
-    Material* material = drawInfo->getMaterial();
+    // check for merge draw
+    auto enableBatch = !entity->getUseLocal();
+    if (enableBatch && canMergeMiddlewareDraw(entity, drawInfo)) {
+        appendMiddlewareDraw(drawInfo);
+        return;
+    }
+
+    generateBatch(_currEntity, _currDrawInfo);
+    _currMiddlewareIbCount = 0;
+    _currLayer = entity->getNode()->getLayer();
+    _currMaterial = drawInfo->getMaterial();
+    _currTexture = drawInfo->getTexture();
+    _currMeshBuffer = drawInfo->getMeshBuffer();
+    _currEntity = entity;
+    _currDrawInfo = drawInfo;
+    _currHash = 0;
+
+    _middlewareRun.clear();
+    _middlewareRunFormat = getAttributesHash(_currMeshBuffer->getAttributes());
+    _middlewareRunVertexCount = 0;
+    _middlewareRunIsMult = enableBatch && isMultMaterial(_currMaterial) && hasFloatColor(_currMeshBuffer->getAttributes());
+    _middlewareTextureCount = 0;
+    appendMiddlewareDraw(drawInfo);
+}
+
+bool Batcher2d::canMergeMiddlewareDraw(RenderEntity* entity, RenderDrawInfo* drawInfo) const {
+    if (_currDrawInfo == nullptr || _middlewareRun.empty() || _currDrawInfo->getEnumDrawInfoType() != RenderDrawInfoType::MIDDLEWARE) {
+        return false;
+    }
+    if (_currEntity->getUseLocal() || entity->getNode()->getLayer() != _currLayer || drawInfo->getMaterial()->getHash() != _currMaterial->getHash()) {
+        return false;
+    }
+
+    auto* meshBuffer = drawInfo->getMeshBuffer();
     auto* texture = drawInfo->getTexture();
-    auto* sampler = drawInfo->getSampler();
+    const auto& last = _middlewareRun.back();
+    const bool contiguous = meshBuffer == last.meshBuffer && drawInfo->getIndexOffset() == last.indexOffset + last.indexCount;
+    if (contiguous && texture == _currTexture && !_middlewareRunIsMult && _middlewareRun.size() == 1) {
+        // still drawn straight from the middleware buffer
+        return true;
+    }
+
+    // Otherwise the run is compacted into a batch buffer which needs the same vertex format.
+    if (meshBuffer != last.meshBuffer && getAttributesHash(meshBuffer->getAttributes()) != _middlewareRunFormat) {
+        return false;
+    }
+    uint32_t vertexStart = 0;
+    uint32_t vertexEnd = 0;
+    getIndexedVertexRange(meshBuffer, drawInfo->getIndexOffset(), drawInfo->getIbCount(), &vertexStart, &vertexEnd);
+    if (_middlewareRunVertexCount + (vertexEnd - vertexStart) > MAX_MIDDLEWARE_BATCH_VERTICES) {
+        return false;
+    }
+
+    if (!_middlewareRunIsMult) {
+        return texture == _currTexture;
+    }
+    if (_middlewareTextureCount < _middlewareTextures.size()) {
+        return true;
+    }
+    for (uint32_t i = 0; i < _middlewareTextureCount; i++) {
+        if (_middlewareTextures[i].texture == texture) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Batcher2d::appendMiddlewareDraw(RenderDrawInfo* drawInfo) {
     auto* meshBuffer = drawInfo->getMeshBuffer();
+    auto* texture = drawInfo->getTexture();
+    uint32_t indexOffset = drawInfo->getIndexOffset();
+    uint32_t indexCount = drawInfo->getIbCount();
+    uint32_t vertexStart = 0;
+    uint32_t vertexEnd = 0;
+    getIndexedVertexRange(meshBuffer, indexOffset, indexCount, &vertexStart, &vertexEnd);
+
+    int32_t texId = -1;
+    if (_middlewareRunIsMult) {
+        for (uint32_t i = 0; i < _middlewareTextureCount; i++) {
+            if (_middlewareTextures[i].texture == texture) {
+                texId = static_cast<int32_t>(i);
+                break;
+            }
+        }
+        if (texId < 0) {
+            texId = static_cast<int32_t>(_middlewareTextureCount);
+            _middlewareTextures[_middlewareTextureCount++] = {texture, drawInfo->getSampler()};
+        }
+    }
 
-    // check for merge draw
-    auto enableBatch = !entity->getUseLocal();
-    if (enableBatch && _currTexture == texture && _currMeshBuffer == meshBuffer && !_currEntity->getUseLocal() && material->getHash() == _currMaterial->getHash() && drawInfo->getIndexOffset() == _currDrawInfo->getIndexOffset() + _currMiddlewareIbCount && layer == _currLayer) {
-        _currMiddlewareIbCount += drawInfo->getIbCount();
-    } else {
-        generateBatch(_currEntity, _currDrawInfo);
-        _currMiddlewareIbCount = drawInfo->getIbCount();
-        _currLayer = layer;
-        _currMaterial = material;
-        _currTexture = texture;
-        _currMeshBuffer = meshBuffer;
-        _currEntity = entity;
-        _currDrawInfo = drawInfo;
-        _currHash = 0;
+    _currMiddlewareIbCount += indexCount;
+    if (!_middlewareRun.empty()) {
+        auto& last = _middlewareRun.back();
+        if (last.meshBuffer == meshBuffer && last.texId == texId && last.indexOffset + last.indexCount == indexOffset) {
+            _middlewareRunVertexCount -= last.vertexEnd - last.vertexStart;
+            last.indexCount += indexCount;
+            last.vertexStart = std::min(last.vertexStart, vertexStart);
+            last.vertexEnd = std::max(last.vertexEnd, vertexEnd);
+            _middlewareRunVertexCount += last.vertexEnd - last.vertexStart;
+            return;
+        }
     }
+    _middlewareRun.push_back({meshBuffer, indexOffset, indexCount, vertexStart, vertexEnd, texId});
+    _middlewareRunVertexCount += vertexEnd - vertexStart;
 }
 
 CC_FORCE_INLINE void Batcher2d::handleSubNode(RenderEntity* entity, RenderDrawInfo* drawInfo) { // NOLINT
@@ -679,21 +1163,28 @@ void Batcher2d::generateBatch(RenderEntity* entity, RenderDrawInfo* drawInfo) {
 }
 
 void Batcher2d::generateBatchForMiddleware(RenderEntity* entity, RenderDrawInfo* drawInfo) {
-    auto layer = entity->getNode()->getLayer();
     auto* material = drawInfo->getMaterial();
     auto* texture = drawInfo->getTexture();
     auto* sampler = drawInfo->getSampler();
     auto* meshBuffer = drawInfo->getMeshBuffer();
-    // set meshbuffer offset
-    auto indexOffset = drawInfo->getIndexOffset();
+    gfx::InputAssembler* ia = nullptr;
+    uint32_t firstIndex = drawInfo->getIndexOffset();
     auto indexCount = _currMiddlewareIbCount;
-    indexOffset += indexCount;
-    if (meshBuffer->getIndexOffset() < indexOffset) {
-        meshBuffer->setIndexOffset(indexOffset);
-    }
+    if (_middlewareRunIsMult || _middlewareRun.size() > 1) {
+        ia = compactMiddlewareRun(&firstIndex);
+    } else {
+        // set meshbuffer offset
+        auto indexOffset = firstIndex + indexCount;
+        if (meshBuffer->getIndexOffset() < indexOffset) {
+            meshBuffer->setIndexOffset(indexOffset);
+        }
 
-    meshBuffer->setDirty(true);
-    gfx::InputAssembler* ia = meshBuffer->requireFreeIA(getDevice());
+        meshBuffer->setDirty(true);
+        ia = meshBuffer->requireFreeIA(getDevice());
+    }
+    if (_middlewareRunIsMult) {
+        material = getMiddlewareMultMaterial(material);
+    }
 
     // stencilstage
     auto stencilStage = _stencilManager->getStencilStage();
@@ -703,7 +1194,7 @@ void Batcher2d::generateBatchForMiddleware(RenderEntity* entity, RenderDrawInfo*
     auto* curdrawBatch = _drawBatchPool.alloc();
     curdrawBatch->setVisFlags(_currLayer);
     curdrawBatch->setInputAssembler(ia);
-    curdrawBatch->setFirstIndex(drawInfo->getIndexOffset());
+    curdrawBatch->setFirstIndex(firstIndex);
     curdrawBatch->setIndexCount(indexCount);
     curdrawBatch->fillPass(material, depthStencil, dssHash);
     const auto& pass = curdrawBatch->getPasses().at(0);
@@ -720,6 +1211,85 @@ void Batcher2d::generateBatchForMiddleware(RenderEntity* entity, RenderDrawInfo*
     _currMeshBuffer = nullptr;
 }
 
+// Copies the vertices and rebased indices of the current middleware run into a batch buffer, multi textured runs
+// get the texture slot encoded into the red channel like the Mult-effect components.
+gfx::InputAssembler* Batcher2d::compactMiddlewareRun(uint32_t* firstIndex) {
+    auto* batchBuffer = requireMiddlewareBatchBuffer(_middlewareRun.front().meshBuffer, _middlewareRunVertexCount);
+    const uint32_t floatsPerVertex = batchBuffer->floatsPerVertex;
+    *firstIndex = batchBuffer->indexCount;
+
+    const uint32_t vertexCount = batchBuffer->vertexCount + _middlewareRunVertexCount;
+    const uint32_t indexCount = batchBuffer->indexCount + _currMiddlewareIbCount;
+    if (batchBuffer->vData.size() < vertexCount * floatsPerVertex) {
+        batchBuffer->vData.resize(std::max(vertexCount * floatsPerVertex, static_cast<uint32_t>(batchBuffer->vData.size() * 2)));
+    }
+    if (batchBuffer->iData.size() < indexCount) {
+        batchBuffer->iData.resize(std::max(indexCount, static_cast<uint32_t>(batchBuffer->iData.size() * 2)));
+    }
+
+    for (const auto& range : _middlewareRun) {
+        const uint32_t count = range.vertexEnd - range.vertexStart;
+        float* dstV = batchBuffer->vData.data() + batchBuffer->vertexCount * floatsPerVertex;
+        memcpy(dstV, range.meshBuffer->getVData() + range.vertexStart * floatsPerVertex, count * floatsPerVertex * sizeof(float));
+        if (range.texId >= 0) {
+            for (uint32_t i = 0; i < count * floatsPerVertex; i += floatsPerVertex) {
+                dstV[i + 5] = floor(dstV[i + 5] * 100000) * 10 + static_cast<float>(range.texId);
+            }
+        }
+
+        const uint16_t* srcI = range.meshBuffer->getIData() + range.indexOffset;
+        uint16_t* dstI = batchBuffer->iData.data() + batchBuffer->indexCount;
+        const uint32_t base = batchBuffer->vertexCount;
+        for (uint32_t i = 0; i < range.indexCount; i++) {
+            dstI[i] = static_cast<uint16_t>(srcI[i] - range.vertexStart + base);
+        }
+
+        batchBuffer->vertexCount += count;
+        batchBuffer->indexCount += range.indexCount;
+    }
+
+    return batchBuffer->meshBuffer.requireFreeIA(getDevice());
+}
+
+MiddlewareBatchBuffer* Batcher2d::requireMiddlewareBatchBuffer(UIMeshBuffer* srcBuffer, uint32_t vertexCount) {
+    auto& list = _middlewareBatchBuffers[_middlewareRunFormat];
+    while (list.used < list.buffers.size() && list.buffers[list.used]->vertexCount + vertexCount > MAX_MIDDLEWARE_BATCH_VERTICES) {
+        ++list.used;
+    }
+    if (list.used == list.buffers.size()) {
+        auto attrs = srcBuffer->getAttributes();
+        auto batchBuffer = std::make_unique<MiddlewareBatchBuffer>();
+        batchBuffer->floatsPerVertex = getAttributesStride(attrs) / sizeof(float);
+        // never shrinks, the gfx buffers upload their whole size from here
+        batchBuffer->vData.resize(MIN_MIDDLEWARE_BATCH_VERTICES * batchBuffer->floatsPerVertex);
+        batchBuffer->iData.resize(MIN_MIDDLEWARE_BATCH_VERTICES * 3 / 2);
+        batchBuffer->meshBuffer.initialize(std::move(attrs), true);
+        list.buffers.push_back(std::move(batchBuffer));
+    }
+    return list.buffers[list.used].get();
+}
+
+Material* Batcher2d::getMiddlewareMultMaterial(Material* material) {
+    auto& pool = _middlewareMultMaterialPools[material->getHash()];
+    if (pool.used == pool.materials.size()) {
+        auto* multMaterial = ccnew Material();
+        multMaterial->copy(material);
+        pool.materials.emplace_back(multMaterial);
+    }
+    Material* multMaterial = pool.materials[pool.used++];
+
+    const auto& pass = multMaterial->getPasses()->at(0);
+    for (uint32_t i = 0; i < _middlewareTextureCount; i++) {
+        ccstd::string name = "texture" + std::to_string(i);
+        uint32_t binding = scene::Pass::getBindingFromHandle(pass->getHandle(name));
+        pass->bindTexture(binding, _middlewareTextures[i].texture, 0);
+        pass->bindSampler(binding, _middlewareTextures[i].sampler, 0);
+    }
+    // the unused slots get the default texture, the state of the component multi texture batch is left alone
+    filltexture(multMaterial, _middlewareTextureCount);
+    return multMaterial;
+}
+
 void Batcher2d::resetRenderStates() {
     _currMaterial = nullptr;
     _currTexture = nullptr;
@@ -729,6 +1299,9 @@ void Batcher2d::resetRenderStates() {
     _currEntity = nullptr;
     _currMiddlewareIbCount = 0;
     _currDrawInfo = nullptr;
+    _middlewareRun.clear();
+    _middlewareRunIsMult = false;
+    _middlewareTextureCount = 0;
     g_mult_next();
 }
 
@@ -764,6 +1337,64 @@ gfx::DescriptorSet* Batcher2d::getDescriptorSet(gfx::Texture* texture, gfx::Samp
     return ds;
 }
 
+void Batcher2d::allocateLocalUBO(LocalDSBF* localDSBF) {
+    auto* device = getDevice();
+    if (_localUBOStride == 0) {
+        const uint32_t alignment = std::max(device->getCapabilities().uboOffsetAlignment, 1U);
+        _localUBOStride = (pipeline::UBOLocal::SIZE + alignment - 1) / alignment * alignment / sizeof(float);
+    }
+
+    uint32_t pageIndex = 0;
+    while (pageIndex < _localUBOPages.size() && _localUBOPages[pageIndex].freeSlots.empty()) {
+        ++pageIndex;
+    }
+    if (pageIndex == _localUBOPages.size()) {
+        LocalUBOPage page;
+        page.buffer = device->createBuffer({
+            gfx::BufferUsageBit::UNIFORM | gfx::BufferUsageBit::TRANSFER_DST,
+            gfx::MemoryUsageBit::HOST | gfx::MemoryUsageBit::DEVICE,
+            _localUBOStride * LOCAL_UBO_PAGE_SLOTS * static_cast<uint32_t>(sizeof(float)),
+            _localUBOStride * static_cast<uint32_t>(sizeof(float)),
+        });
+        page.data.resize(_localUBOStride * LOCAL_UBO_PAGE_SLOTS, 0.F);
+        for (uint32_t i = LOCAL_UBO_PAGE_SLOTS; i > 0; i--) {
+            page.freeSlots.push_back(i - 1);
+        }
+        _localUBOPages.push_back(std::move(page));
+    }
+
+    auto& page = _localUBOPages[pageIndex];
+    localDSBF->page = pageIndex;
+    localDSBF->slot = page.freeSlots.back();
+    page.freeSlots.pop_back();
+    localDSBF->uboBuf = device->createBuffer(gfx::BufferViewInfo{
+        page.buffer.get(),
+        localDSBF->slot * _localUBOStride * static_cast<uint32_t>(sizeof(float)),
+        pipeline::UBOLocal::SIZE,
+    });
+
+    // the slot may have been used before, make sure the first update uploads
+    float* data = page.data.data() + localDSBF->slot * _localUBOStride;
+    std::fill(data, data + _localUBOStride, 0.F);
+    data[pipeline::UBOLocal::MAT_WORLD_OFFSET] = NAN;
+}
+
+void Batcher2d::releaseLocalUBO(LocalDSBF* localDSBF) {
+    if (localDSBF->uboBuf == nullptr || localDSBF->page >= _localUBOPages.size()) {
+        return;
+    }
+    _releasedLocalUBOs.push_back({localDSBF->page, localDSBF->slot, _localUBOFrame});
+}
+
+void Batcher2d::updateLocalUBO(LocalDSBF* localDSBF, const Mat4& worldMatrix) {
+    auto& page = _localUBOPages[localDSBF->page];
+    float* data = page.data.data() + localDSBF->slot * _localUBOStride + pipeline::UBOLocal::MAT_WORLD_OFFSET;
+    if (memcmp(data, worldMatrix.m, 16 * sizeof(float)) != 0) {
+        memcpy(data, worldMatrix.m, 16 * sizeof(float));
+        page.dirty = true;
+    }
+}
+
 void Batcher2d::releaseDescriptorSetCache(gfx::Texture* texture, gfx::Sampler* sampler) {
     ccstd::hash_t hash = 2;
     size_t textureHash;
@@ -787,11 +1418,197 @@ bool Batcher2d::initialize() {
 }
 
 void Batcher2d::update() {
+    if (_particleEmittersUpdated) {
+        ParticleManager2D::getInstance()->update(_particleDeltaTime, getWorkers());
+        _particleEmittersUpdated = false;
+    }
     fillBuffersAndMergeBatches();
     resetRenderStates();
     g_mult_reset();
 }
 
+Batcher2dWorkers* Batcher2d::getWorkers() {
+    if (_workers == nullptr) {
+        const uint32_t cores = std::thread::hardware_concurrency();
+        _workers = ccnew Batcher2dWorkers(std::min(cores > 1 ? cores - 1 : 0, MAX_BATCHER_WORKERS));
+    }
+    return _workers;
+}
+
+void Batcher2d::setMotionStreak(RenderDrawInfo* drawInfo, Node* node, float fadeTime, float minSeg, float stroke) { // NOLINT(bugprone-easily-swappable-parameters)
+    auto*& streak = _motionStreaks[drawInfo];
+    if (streak == nullptr) {
+        streak = ccnew MotionStreak2D();
+        streak->setDrawInfo(drawInfo);
+        streak->setFadeTime(fadeTime);
+    } else if (streak->getFadeTime() != fadeTime) {
+        streak->setFadeTime(fadeTime);
+    }
+    streak->setNode(node);
+    streak->setMinSeg(minSeg);
+    streak->setStroke(stroke);
+}
+
+void Batcher2d::updateMotionStreak(RenderDrawInfo* drawInfo, float dt, const Color& color, float opacity) {
+    auto iter = _motionStreaks.find(drawInfo);
+    if (iter == _motionStreaks.end()) {
+        return;
+    }
+    auto* streak = iter->second;
+    streak->setColor(color);
+    streak->setOpacity(opacity);
+    // JS fills the draw info from the chunk of the render data, the strip replaces it each frame
+    drawInfo->setIsMeshBuffer(true);
+    streak->update(dt);
+}
+
+void Batcher2d::resetMotionStreak(RenderDrawInfo* drawInfo) {
+    auto iter = _motionStreaks.find(drawInfo);
+    if (iter == _motionStreaks.end()) {
+        return;
+    }
+    iter->second->reset();
+    iter->second->fillDrawInfo(drawInfo);
+}
+
+void Batcher2d::removeMotionStreak(RenderDrawInfo* drawInfo) {
+    auto iter = _motionStreaks.find(drawInfo);
+    if (iter == _motionStreaks.end()) {
+        return;
+    }
+    delete iter->second;
+    _motionStreaks.erase(iter);
+    drawInfo->setVDataBuffer(nullptr);
+    drawInfo->setIDataBuffer(nullptr);
+    drawInfo->setVbCount(0);
+    drawInfo->setIbCount(0);
+    drawInfo->setIsMeshBuffer(false);
+}
+
+void Batcher2d::setParticleEmitter(RenderDrawInfo* drawInfo, Node* node, const ParticleEmitterConfig2D& config) {
+    auto*& simulator = _particleEmitters[drawInfo];
+    if (simulator == nullptr) {
+        simulator = ccnew ParticleSimulator2D();
+        simulator->setDrawInfo(drawInfo);
+    }
+    simulator->setNode(node);
+    simulator->setName(node->getName());
+    simulator->setConfig(config);
+}
+
+void Batcher2d::setParticleEmitterUVs(RenderDrawInfo* drawInfo, const ccstd::vector<float>& uvs) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter == _particleEmitters.end() || uvs.size() < 8) {
+        return;
+    }
+    iter->second->setUVs(uvs.data());
+}
+
+void Batcher2d::updateParticleEmitter(RenderDrawInfo* drawInfo, float dt, float opacity) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter == _particleEmitters.end()) {
+        return;
+    }
+    auto* simulator = iter->second;
+    simulator->setOpacity(opacity);
+    ParticleManager2D::getInstance()->addSimulator(simulator);
+    _particleDeltaTime = dt;
+    _particleEmittersUpdated = true;
+    // JS fills the draw info from its render data, the quads of the last step replace it until the next one
+    drawInfo->setIsMeshBuffer(true);
+    simulator->fillDrawInfo(drawInfo);
+}
+
+void Batcher2d::resetParticleEmitter(RenderDrawInfo* drawInfo) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter == _particleEmitters.end()) {
+        return;
+    }
+    iter->second->reset();
+    iter->second->fillDrawInfo(drawInfo);
+}
+
+void Batcher2d::stopParticleEmitter(RenderDrawInfo* drawInfo) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter != _particleEmitters.end()) {
+        iter->second->stop();
+    }
+}
+
+void Batcher2d::pauseParticleEmitter(RenderDrawInfo* drawInfo) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter != _particleEmitters.end()) {
+        ParticleManager2D::getInstance()->removeSimulator(iter->second);
+    }
+}
+
+void Batcher2d::removeParticleEmitter(RenderDrawInfo* drawInfo) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter == _particleEmitters.end()) {
+        return;
+    }
+    delete iter->second;
+    _particleEmitters.erase(iter);
+    drawInfo->setVDataBuffer(nullptr);
+    drawInfo->setIDataBuffer(nullptr);
+    drawInfo->setVbCount(0);
+    drawInfo->setIbCount(0);
+    drawInfo->setIsMeshBuffer(false);
+}
+
+uint32_t Batcher2d::getParticleCount(RenderDrawInfo* drawInfo) const {
+    auto iter = _particleEmitters.find(drawInfo);
+    return iter != _particleEmitters.end() ? iter->second->getParticleCount() : 0;
+}
+
+bool Batcher2d::isParticleEmitterActive(RenderDrawInfo* drawInfo) const {
+    auto iter = _particleEmitters.find(drawInfo);
+    return iter != _particleEmitters.end() && iter->second->isActive();
+}
+
+bool Batcher2d::isParticleEmitterFinished(RenderDrawInfo* drawInfo) const {
+    auto iter = _particleEmitters.find(drawInfo);
+    return iter != _particleEmitters.end() && iter->second->isFinished();
+}
+
+void Batcher2d::setParticleEmitterCulling(RenderDrawInfo* drawInfo, ParticleCulling2D culling, bool catchUp, int32_t priority) {
+    auto iter = _particleEmitters.find(drawInfo);
+    if (iter == _particleEmitters.end()) {
+        return;
+    }
+    iter->second->setCulling(culling);
+    iter->second->setCatchUp(catchUp);
+    iter->second->setPriority(priority);
+}
+
+void Batcher2d::setParticleViewRect(float left, float bottom, float right, float top) { // NOLINT(bugprone-easily-swappable-parameters)
+    ParticleManager2D::getInstance()->setViewRect(left, bottom, right, top);
+}
+
+void Batcher2d::clearParticleViewRect() {
+    ParticleManager2D::getInstance()->clearViewRect();
+}
+
+void Batcher2d::setMaxParticles(uint32_t maxParticles) {
+    ParticleManager2D::getInstance()->setMaxParticles(maxParticles);
+}
+
+void Batcher2d::printParticleStats() const {
+    ParticleManager2D::getInstance()->printStats();
+}
+
+void Batcher2d::releaseBatches() {
+    for (auto& batch : _batches) {
+        // cached model batches are owned by their cache
+        if (isModelCacheBatch(batch)) {
+            continue;
+        }
+        batch->clear();
+        _drawBatchPool.free(batch);
+    }
+    _batches.clear();
+}
+
 void Batcher2d::uploadBuffers() {
     if (_batches.empty()) {
         return;
@@ -807,15 +1624,49 @@ void Batcher2d::uploadBuffers() {
             buffer->reset();
         }
     }
+
+    for (auto& pair : _middlewareBatchBuffers) {
+        for (auto& batchBuffer : pair.second.buffers) {
+            if (batchBuffer->vertexCount == 0) {
+                continue;
+            }
+            auto* meshBuffer = &batchBuffer->meshBuffer;
+            meshBuffer->setVData(batchBuffer->vData.data());
+            meshBuffer->setIData(batchBuffer->iData.data());
+            meshBuffer->setByteOffset(batchBuffer->vertexCount * batchBuffer->floatsPerVertex * sizeof(float));
+            meshBuffer->setVertexOffset(batchBuffer->vertexCount);
+            meshBuffer->setIndexOffset(batchBuffer->indexCount);
+            meshBuffer->setDirty(true);
+            meshBuffer->uploadBuffers();
+            meshBuffer->reset();
+            batchBuffer->vertexCount = 0;
+            batchBuffer->indexCount = 0;
+        }
+        pair.second.used = 0;
+    }
+
+    for (auto& page : _localUBOPages) {
+        if (page.dirty) {
+            page.buffer->update(page.data.data());
+            page.dirty = false;
+        }
+    }
     updateDescriptorSet();
 }
 
 void Batcher2d::reset() {
-    for (auto& batch : _batches) {
-        batch->clear();
-        _drawBatchPool.free(batch);
+    releaseBatches();
+
+    // release the caches of models which were not drawn this frame, they may be destroyed already
+    for (auto iter = _modelBatchCaches.begin(); iter != _modelBatchCaches.end();) {
+        if (!iter->second.used) {
+            releaseModelBatchCache(&iter->second);
+            iter = _modelBatchCaches.erase(iter);
+        } else {
+            iter->second.used = false;
+            ++iter;
+        }
     }
-    _batches.clear();
 
     for (auto& meshRenderData : _meshRenderDrawInfo) {
         meshRenderData->resetMeshIA();
@@ -839,6 +1690,26 @@ void Batcher2d::reset() {
     _currMaterial = nullptr;
     _currTexture = nullptr;
     _currSampler = nullptr;
+    _clipRectStack.clear();
+    _maskContentChecks.clear();
+    _analyticMaskEntity = nullptr;
+    _analyticMaskActiveMaterials.clear();
+    for (auto& pair : _analyticMaskMaterialPools) {
+        pair.second.used = 0;
+    }
+    for (auto& pair : _middlewareMultMaterialPools) {
+        pair.second.used = 0;
+    }
+    // draw infos and local UBOs released REUSE_DELAY_FRAMES frames ago can be handed out again
+    RenderDrawInfoPool::getInstance()->endFrame();
+    ++_localUBOFrame;
+    size_t releasedCount = 0;
+    while (releasedCount < _releasedLocalUBOs.size() && _localUBOFrame - _releasedLocalUBOs[releasedCount].frame >= RenderDrawInfoPool::REUSE_DELAY_FRAMES) {
+        const auto& released = _releasedLocalUBOs[releasedCount];
+        _localUBOPages[released.page].freeSlots.push_back(released.slot);
+        ++releasedCount;
+    }
+    _releasedLocalUBOs.erase(_releasedLocalUBOs.begin(), _releasedLocalUBOs.begin() + static_cast<std::ptrdiff_t>(releasedCount));
 
     // stencilManager
 }
@@ -846,24 +1717,26 @@ void Batcher2d::reset() {
 void Batcher2d::insertMaskBatch(RenderEntity* entity) {
     generateBatch(_currEntity, _currDrawInfo);
     resetRenderStates();
-    createClearModel();
-    _maskClearModel->setNode(entity->getNode());
-    _maskClearModel->setTransform(entity->getNode());
+    auto layer = entity->getNode()->getLayer();
+    if (layer != _stencilLayer) {
+        _stencilManager->resetDirtyBits();
+        _stencilLayer = layer;
+    }
     _stencilManager->pushMask();
-    auto stage = _stencilManager->clear(entity);
-
-    gfx::DepthStencilState* depthStencil = nullptr;
-    ccstd::hash_t dssHash = 0;
-    if (_maskClearMtl != nullptr) {
-        depthStencil = _stencilManager->getDepthStencilState(stage, _maskClearMtl);
-        dssHash = _stencilManager->getStencilHash(stage);
+    // Inverted masks always fill their bit, the others only clear if no clean stencil bit is left.
+    if (entity->getIsMaskInverted() || _stencilManager->needClear()) {
+        insertClearBatch(entity, _stencilManager->clear(entity));
     }
+    _stencilManager->enterLevel(entity);
+}
 
-    // Model
-    if (_maskClearModel == nullptr) return;
-    auto stamp = CC_CURRENT_ENGINE()->getTotalFrames();
-    _maskClearModel->updateTransform(stamp);
-    _maskClearModel->updateUBOs(stamp);
+void Batcher2d::insertClearBatch(RenderEntity* entity, StencilStage stage) {
+    createClearModel();
+    if (_maskClearModel == nullptr || _maskClearMtl == nullptr) return;
+
+    // The clear quad is in clip space, its transform and local UBO never change.
+    gfx::DepthStencilState* depthStencil = _stencilManager->getDepthStencilState(stage, _maskClearMtl);
+    ccstd::hash_t dssHash = _stencilManager->getStencilHash(stage);
 
     const auto& subModelList = _maskClearModel->getSubModels();
     for (const auto& submodel : subModelList) {
@@ -876,8 +1749,213 @@ void Batcher2d::insertMaskBatch(RenderEntity* entity) {
         curdrawBatch->fillPass(_maskClearMtl, depthStencil, dssHash, &(submodel->getPatches()));
         _batches.push_back(curdrawBatch);
     }
+}
 
-    _stencilManager->enterLevel(entity);
+// Whether the content supports it is known from the last frames, it is checked again while the content is walked.
+bool Batcher2d::enterStencilFreeMask(RenderEntity* entity) {
+    const bool clipCandidate = entity->getUseGeometricClip() && !entity->getIsMaskInverted();
+    const bool analyticCandidate = entity->getAnalyticMaskShape() != AnalyticMaskShape::NONE;
+    if (!clipCandidate && !analyticCandidate) {
+        return false;
+    }
+    const bool stencilFree = pushClipRect(entity) || pushAnalyticMask(entity);
+    _maskContentChecks.push_back({entity, analyticCandidate, stencilFree, true});
+    return stencilFree;
+}
+
+bool Batcher2d::exitStencilFreeMask(RenderEntity* entity) {
+    if (!_maskContentChecks.empty() && _maskContentChecks.back().entity == entity) {
+        const auto& check = _maskContentChecks.back();
+        entity->setStencilFreeMaskState(check.supported ? StencilFreeMaskState::SUPPORTED : StencilFreeMaskState::UNSUPPORTED);
+        _maskContentChecks.pop_back();
+    }
+    if (isClippingMask(entity)) {
+        _clipRectStack.pop_back();
+        return true;
+    }
+    if (_analyticMaskEntity != nullptr && _analyticMaskEntity == entity) {
+        _analyticMaskEntity = nullptr;
+        _analyticMaskActiveMaterials.clear();
+        return true;
+    }
+    return false;
+}
+
+bool Batcher2d::pushClipRect(RenderEntity* entity) {
+    if (!entity->getUseGeometricClip() || entity->getIsMaskInverted()) {
+        return false;
+    }
+    Node* node = entity->getNode();
+    const Mat4& matrix = node->getWorldMatrix();
+    // Rotated masks and content which is not made of plain quads still need stencil.
+    if (!isAxisAligned(matrix) || !canMaskWithoutStencil(entity, false)) {
+        return false;
+    }
+
+    const ClipRect& localRect = entity->getGeometricClipRect();
+    Vec3 lb;
+    Vec3 rt;
+    lb.transformMat4(Vec3(localRect.left, localRect.bottom, 0.F), matrix);
+    rt.transformMat4(Vec3(localRect.right, localRect.top, 0.F), matrix);
+
+    auto& entry = _clipRectStack.emplace_back();
+    entry.entity = entity;
+    entry.rect.left = std::min(lb.x, rt.x);
+    entry.rect.right = std::max(lb.x, rt.x);
+    entry.rect.bottom = std::min(lb.y, rt.y);
+    entry.rect.top = std::max(lb.y, rt.y);
+    if (_clipRectStack.size() > 1) {
+        const ClipRect& parent = _clipRectStack[_clipRectStack.size() - 2].rect;
+        entry.rect.left = std::max(entry.rect.left, parent.left);
+        entry.rect.bottom = std::max(entry.rect.bottom, parent.bottom);
+        entry.rect.right = std::max(entry.rect.left, std::min(entry.rect.right, parent.right));
+        entry.rect.top = std::max(entry.rect.bottom, std::min(entry.rect.top, parent.top));
+    }
+    return true;
+}
+
+bool Batcher2d::pushAnalyticMask(RenderEntity* entity) {
+    if (_analyticMaskEntity != nullptr || entity->getAnalyticMaskShape() == AnalyticMaskShape::NONE) {
+        return false;
+    }
+    Node* node = entity->getNode();
+    const Mat4& matrix = node->getWorldMatrix();
+    if (!isAxisAligned(matrix) || !canMaskWithoutStencil(entity, true)) {
+        return false;
+    }
+
+    const ClipRect& localRect = entity->getAnalyticMaskRect();
+    Vec3 center;
+    center.transformMat4(Vec3((localRect.left + localRect.right) * 0.5F, (localRect.bottom + localRect.top) * 0.5F, 0.F), matrix);
+    const float scaleX = std::abs(matrix.m[0]);
+    const float scaleY = std::abs(matrix.m[5]);
+    _analyticMaskRect.set(center.x, center.y, (localRect.right - localRect.left) * 0.5F * scaleX, (localRect.top - localRect.bottom) * 0.5F * scaleY);
+    _analyticMaskParams.set(entity->getAnalyticMaskCornerRadius() * std::min(scaleX, scaleY),
+                            static_cast<float>(entity->getAnalyticMaskShape()),
+                            entity->getIsMaskInverted() ? 1.F : 0.F,
+                            0.F);
+    _analyticMaskEntity = entity;
+    _analyticMaskActiveMaterials.clear();
+    return true;
+}
+
+// The effect of the material has to define USE_ANALYTIC_MASK, checked once per pass.
+bool Batcher2d::supportsAnalyticMask(Material* material) {
+    if (material == nullptr || material->getPasses()->empty()) {
+        return false;
+    }
+    const auto& pass = material->getPasses()->at(0);
+    auto iter = _analyticMaskSupport.find(pass->getHash());
+    if (iter != _analyticMaskSupport.end()) {
+        return iter->second;
+    }
+    bool supported = false;
+    const auto* programInfo = ProgramLib::getInstance()->getTemplate(pass->getProgram());
+    if (programInfo != nullptr && pass->getHandle(ANALYTIC_MASK_RECT) != 0 && pass->getHandle(ANALYTIC_MASK_PARAMS) != 0) {
+        for (const auto& define : programInfo->defines) {
+            if (define.name == ANALYTIC_MASK_DEFINE) {
+                supported = true;
+                break;
+            }
+        }
+    }
+    _analyticMaskSupport.emplace(pass->getHash(), supported);
+    return supported;
+}
+
+// Each analytic mask needs its own pass uniforms, children sharing a material below the same mask share one copy.
+// Copies are pooled by material hash and reused by the masks of the next frames.
+Material* Batcher2d::getAnalyticMaskMaterial(Material* material) {
+    const ccstd::hash_t hash = material->getHash();
+    auto iter = _analyticMaskActiveMaterials.find(hash);
+    if (iter != _analyticMaskActiveMaterials.end()) {
+        return iter->second;
+    }
+
+    auto& pool = _analyticMaskMaterialPools[hash];
+    if (pool.used == pool.materials.size()) {
+        auto* maskMaterial = ccnew Material();
+        maskMaterial->copy(material);
+        maskMaterial->recompileShaders({{ANALYTIC_MASK_DEFINE, true}});
+        pool.materials.emplace_back(maskMaterial);
+    }
+    Material* maskMaterial = pool.materials[pool.used++];
+    maskMaterial->setProperty(ANALYTIC_MASK_RECT, MaterialPropertyVariant(MaterialProperty(_analyticMaskRect)));
+    maskMaterial->setProperty(ANALYTIC_MASK_PARAMS, MaterialPropertyVariant(MaterialProperty(_analyticMaskParams)));
+    _analyticMaskActiveMaterials.emplace(hash, maskMaterial);
+    return maskMaterial;
+}
+
+// Checks if everything below a mask can be masked on the CPU (rect clip) or in the shader (analytic).
+// The subtree is only walked for masks seen the first time, afterwards the state from the last walk is used.
+bool Batcher2d::canMaskWithoutStencil(RenderEntity* entity, bool analytic) {
+    auto state = entity->getStencilFreeMaskState();
+    if (state == StencilFreeMaskState::UNCHECKED) {
+        state = canMaskContentWithoutStencil(entity->getNode(), analytic) ? StencilFreeMaskState::SUPPORTED : StencilFreeMaskState::UNSUPPORTED;
+        entity->setStencilFreeMaskState(state);
+    }
+    return state == StencilFreeMaskState::SUPPORTED;
+}
+
+bool Batcher2d::canMaskContentWithoutStencil(Node* node, bool analytic) { // NOLINT(misc-no-recursion)
+    for (const auto& child : node->getChildren()) {
+        if (!child->isActiveInHierarchy()) {
+            continue;
+        }
+        auto* entity = static_cast<RenderEntity*>(child->getUserData());
+        // nested masks only write stencil, their content is checked below
+        if (entity && entity->isEnabled() && !entity->getIsMask() && !canDrawWithoutStencil(entity, child, analytic)) {
+            return false;
+        }
+        if (!canMaskContentWithoutStencil(child, analytic)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Batcher2d::canDrawWithoutStencil(RenderEntity* entity, Node* node, bool analytic) {
+    if (entity->getRenderEntityType() == RenderEntityType::CROSSED) {
+        return false;
+    }
+    if (entity->getUseLocal() || (!analytic && !isAxisAligned(node->getWorldMatrix()))) {
+        return false;
+    }
+    uint32_t size = entity->getRenderDrawInfosSize();
+    for (uint32_t i = 0; i < size; i++) {
+        auto* drawInfo = entity->getRenderDrawInfoAt(i);
+        if (drawInfo->getEnumDrawInfoType() != RenderDrawInfoType::COMP) {
+            return false;
+        }
+        if (analytic) {
+            if (!supportsAnalyticMask(drawInfo->getMaterial())) {
+                return false;
+            }
+        } else if (drawInfo->getIsMeshBuffer() || drawInfo->isVertexPositionInWorld() || !isQuadList(drawInfo)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Called for the entities walked below the masks being checked. If the content of a mask masked without stencil in
+// this frame doesn't support it anymore, e.g. a child was rotated, update() fills the frame again.
+void Batcher2d::checkMaskContent(RenderEntity* entity, Node* node) {
+    // -1 while not checked, per mode
+    int32_t results[2] = {-1, -1};
+    for (auto& check : _maskContentChecks) {
+        if (!check.supported) {
+            continue;
+        }
+        auto& result = results[check.analytic ? 1 : 0];
+        if (result < 0) {
+            result = canDrawWithoutStencil(entity, node, check.analytic) ? 1 : 0;
+        }
+        if (result == 0) {
+            check.supported = false;
+            _refillFrame = _refillFrame || check.stencilFree;
+        }
+    }
 }
 
 void Batcher2d::createClearModel() {
@@ -910,9 +1988,20 @@ void Batcher2d::createClearModel() {
         _maskModelMesh->setSubMeshIdx(0);
 
         _maskClearModel->initSubModel(0, _maskModelMesh, _maskClearMtl);
+
+        _maskClearNode = ccnew Node();
+        _maskClearModel->setNode(_maskClearNode);
+        _maskClearModel->setTransform(_maskClearNode);
+        auto stamp = CC_CURRENT_ENGINE()->getTotalFrames();
+        _maskClearModel->updateTransform(stamp);
+        _maskClearModel->updateUBOs(stamp);
     }
 }
 
+Batcher2d* Batcher2d::getAliveInstance() {
+    return aliveInstance;
+}
+
 void Batcher2d::setSorting2DCount(int32_t v) {
     sorting2DCount = v;
 }
@@ -23,6 +23,7 @@
 ****************************************************************************/
 
 #pragma once
+#include "2d/renderer/Batcher2dWorkers.h"
 #include "2d/renderer/RenderDrawInfo.h"
 #include "2d/renderer/RenderEntity.h"
 #include "2d/renderer/UIMeshBuffer.h"
@@ -35,8 +36,15 @@
 #include "renderer/gfx-base/states/GFXSampler.h"
 #include "scene/DrawBatch2D.h"
 
+#include <array>
+#include <memory>
+
 namespace cc {
 class Root;
+class MotionStreak2D;
+class ParticleSimulator2D;
+struct ParticleEmitterConfig2D;
+enum class ParticleCulling2D : uint8_t;
 using UIMeshBufferArray = ccstd::vector<UIMeshBuffer*>;
 using UIMeshBufferMap = ccstd::unordered_map<uint16_t, UIMeshBufferArray>;
 
@@ -44,9 +52,111 @@ struct RecordedRendererInfo {
     RenderEntity *renderEntity{nullptr};
 };
 
+struct ClipRectEntry {
+    // weak reference
+    RenderEntity *entity{nullptr};
+    // world space, already intersected with the parent entries
+    ClipRect rect;
+};
+
+// A mask whose content is checked while it is walked, the result decides if the next frames can skip stencil.
+struct MaskContentCheck {
+    // weak reference
+    RenderEntity *entity{nullptr};
+    bool analytic{false};
+    // the content is masked without stencil in this frame
+    bool stencilFree{false};
+    bool supported{true};
+};
+
+struct MaterialCopyPool {
+    ccstd::vector<IntrusivePtr<Material>> materials;
+    uint32_t used{0};
+};
+
+// Draw batches of a UI model, reused while its material, stencil state, layer and sub models are unchanged.
+struct ModelBatchCache {
+    // keeps the model, and so the key of the cache, alive until the cache is released
+    IntrusivePtr<scene::Model> model;
+    // manage memory manually
+    ccstd::vector<scene::DrawBatch2D *> batches;
+    // weak reference
+    Material *material{nullptr};
+    ccstd::hash_t materialHash{0};
+    ccstd::hash_t dssHash{0};
+    uint32_t layer{0};
+    // drawn in the current frame
+    bool used{false};
+};
+
+// Vertex work of an unclipped component draw, run after the walk and split across the workers.
+struct VertexFillTask {
+    // weak reference
+    RenderEntity *entity{nullptr};
+    // weak reference
+    RenderDrawInfo *drawInfo{nullptr};
+    bool fillPosition{false};
+    bool fillColor{false};
+    bool fillTextureId{false};
+    float textureIdColor{0.F};
+};
+
+struct MiddlewareDrawRange {
+    // weak reference
+    UIMeshBuffer *meshBuffer{nullptr};
+    uint32_t indexOffset{0};
+    uint32_t indexCount{0};
+    // vertices referenced by the indices, [vertexStart, vertexEnd)
+    uint32_t vertexStart{0};
+    uint32_t vertexEnd{0};
+    // multi texture slot, -1 if the run is not multi textured
+    int32_t texId{-1};
+};
+
+struct MiddlewareTextureSlot {
+    // weak reference
+    gfx::Texture *texture{nullptr};
+    // weak reference
+    gfx::Sampler *sampler{nullptr};
+};
+
+// Per frame buffer which middleware draws of different entities are compacted into.
+struct MiddlewareBatchBuffer {
+    UIMeshBuffer meshBuffer;
+    ccstd::vector<float> vData;
+    ccstd::vector<uint16_t> iData;
+    uint32_t floatsPerVertex{0};
+    uint32_t vertexCount{0};
+    uint32_t indexCount{0};
+};
+
+struct MiddlewareBatchBufferList {
+    ccstd::vector<std::unique_ptr<MiddlewareBatchBuffer>> buffers;
+    uint32_t used{0};
+};
+
+// Local UBOs of useLocal draws are buffer views into shared pages, uploaded once per frame if any of them changed.
+struct LocalUBOPage {
+    IntrusivePtr<gfx::Buffer> buffer;
+    ccstd::vector<float> data;
+    ccstd::vector<uint32_t> freeSlots;
+    bool dirty{false};
+};
+
+// A released slot is reused after RenderDrawInfoPool::REUSE_DELAY_FRAMES frames, the batches of the frame in
+// flight may still read it.
+struct ReleasedLocalUBO {
+    uint32_t page{0};
+    uint32_t slot{0};
+    // frame count when the slot was released
+    uint32_t frame{0};
+};
+
 class Batcher2d final {
 public:
     static void setSorting2DCount(int32_t v);
+    // nullptr once the batcher is destroyed, draw infos released by JS may outlive it
+    static Batcher2d* getAliveInstance();
     
     Batcher2d();
     explicit Batcher2d(Root* root);
@@ -62,13 +172,54 @@ public:
     void syncRootNodesToNative(ccstd::vector<Node*>&& rootNodes);
     void releaseDescriptorSetCache(gfx::Texture* texture, gfx::Sampler* sampler);
 
+    // The threads filling vertices after the walk, created on first use. Shared with ParticleManager2D, which steps
+    // before the walk.
+    Batcher2dWorkers* getWorkers();
+
+    // The points and the strip of a MotionStreak under JSB, written into the draw info of the component, see
+    // MotionStreak2D. Keyed by that draw info, removed by the component before it releases its render data.
+    void setMotionStreak(RenderDrawInfo* drawInfo, Node* node, float fadeTime, float minSeg, float stroke);
+    void updateMotionStreak(RenderDrawInfo* drawInfo, float dt, const Color& color, float opacity);
+    void resetMotionStreak(RenderDrawInfo* drawInfo);
+    void removeMotionStreak(RenderDrawInfo* drawInfo);
+
+    // The particles of a ParticleSystem2D under JSB, written into the draw info of the component, see
+    // ParticleSimulator2D. Keyed by that draw info, removed by the component before it releases its render data.
+    // The config is sent again when the component resets, an emitter updated in a frame is stepped by
+    // ParticleManager2D at the start of update(), the others keep their particles until they are updated again.
+    void setParticleEmitter(RenderDrawInfo* drawInfo, Node* node, const ParticleEmitterConfig2D& config);
+    // u, v of the 4 corners, as SpriteFrame.uv
+    void setParticleEmitterUVs(RenderDrawInfo* drawInfo, const ccstd::vector<float>& uvs);
+    void updateParticleEmitter(RenderDrawInfo* drawInfo, float dt, float opacity);
+    void resetParticleEmitter(RenderDrawInfo* drawInfo);
+    void stopParticleEmitter(RenderDrawInfo* drawInfo);
+    // not stepped until the next updateParticleEmitter, e.g. while the component is disabled
+    void pauseParticleEmitter(RenderDrawInfo* drawInfo);
+    void removeParticleEmitter(RenderDrawInfo* drawInfo);
+    uint32_t getParticleCount(RenderDrawInfo* drawInfo) const;
+    bool isParticleEmitterActive(RenderDrawInfo* drawInfo) const;
+    // set once no particle is left after a stop, until the next reset
+    bool isParticleEmitterFinished(RenderDrawInfo* drawInfo) const;
+    // how ParticleManager2D steps the emitter while it is culled, and its share of the particle budget
+    void setParticleEmitterCulling(RenderDrawInfo* drawInfo, ParticleCulling2D culling, bool catchUp, int32_t priority);
+    // the world rect the emitters are culled against and the particle budget of all of them, see ParticleManager2D
+    void setParticleViewRect(float left, float bottom, float right, float top); // NOLINT(bugprone-easily-swappable-parameters)
+    void clearParticleViewRect();
+    void setMaxParticles(uint32_t maxParticles);
+    void printParticleStats() const;
+
     UIMeshBuffer* getMeshBuffer(uint16_t accId, uint16_t bufferId);
     gfx::Device* getDevice();
     inline ccstd::vector<gfx::Attribute>* getDefaultAttribute() { return &_attributes; }
 
     void updateDescriptorSet();
 
+    void allocateLocalUBO(LocalDSBF* localDSBF);
+    void releaseLocalUBO(LocalDSBF* localDSBF);
+    void updateLocalUBO(LocalDSBF* localDSBF, const Mat4& worldMatrix);
+
     void fillBuffersAndMergeBatches();
+    void flushVertexFillTasks();
     void walk(Node* node, float parentOpacity, bool parentColorDirty);
     void handlePostRender(RenderEntity* entity);
     void handleDrawInfo(RenderEntity* entity, RenderDrawInfo* drawInfo, Node* node);
@@ -83,9 +234,42 @@ public:
 private:
     bool _isInit = false;
 
+    void releaseBatches();
+
     void insertMaskBatch(RenderEntity* entity);
+    void insertClearBatch(RenderEntity* entity, StencilStage stage);
     void createClearModel();
 
+    bool enterStencilFreeMask(RenderEntity* entity);
+    bool exitStencilFreeMask(RenderEntity* entity);
+    bool pushClipRect(RenderEntity* entity);
+    bool pushAnalyticMask(RenderEntity* entity);
+    bool canMaskWithoutStencil(RenderEntity* entity, bool analytic);
+    bool canMaskContentWithoutStencil(Node* node, bool analytic);
+    bool canDrawWithoutStencil(RenderEntity* entity, Node* node, bool analytic);
+    bool supportsAnalyticMask(Material* material);
+    void checkMaskContent(RenderEntity* entity, Node* node);
+    void walkRootNodes();
+    void discardFilledBatches();
+    Material* getAnalyticMaskMaterial(Material* material);
+    inline bool isClippingMask(RenderEntity* entity) const {
+        return !_clipRectStack.empty() && _clipRectStack.back().entity == entity;
+    }
+    inline bool isStencilFreeMask(RenderEntity* entity) const {
+        return isClippingMask(entity) || (_analyticMaskEntity != nullptr && _analyticMaskEntity == entity);
+    }
+
+    bool isModelBatchCacheValid(const ModelBatchCache& cache, scene::Model* model, Material* material, ccstd::hash_t dssHash, uint32_t layer) const;
+    void rebuildModelBatchCache(ModelBatchCache* cache, scene::Model* model, Material* material, gfx::DepthStencilState* depthStencil, ccstd::hash_t dssHash, uint32_t layer);
+    void releaseModelBatchCache(ModelBatchCache* cache);
+    bool isModelCacheBatch(scene::DrawBatch2D* batch) const;
+
+    bool canMergeMiddlewareDraw(RenderEntity* entity, RenderDrawInfo* drawInfo) const;
+    void appendMiddlewareDraw(RenderDrawInfo* drawInfo);
+    gfx::InputAssembler* compactMiddlewareRun(uint32_t* firstIndex);
+    MiddlewareBatchBuffer* requireMiddlewareBatchBuffer(UIMeshBuffer* srcBuffer, uint32_t vertexCount);
+    Material* getMiddlewareMultMaterial(Material* material);
+
     gfx::DescriptorSet* getDescriptorSet(gfx::Texture* texture, gfx::Sampler* sampler, const gfx::DescriptorSetLayout* dsLayout);
     
     ccstd::vector<RecordedRendererInfo> &getRecordedRendererInfoQueue();
@@ -106,6 +290,29 @@ private:
     
     ccstd::vector<RecordedRendererInfo> _recordedRendererInfoQueue;
 
+    // weak reference, the scene of each root and the end of its batches
+    ccstd::vector<std::pair<scene::RenderScene*, size_t>> _sceneBatchRanges;
+
+    // keyed by weak model reference, entries not drawn in a frame are released in reset()
+    ccstd::unordered_map<scene::Model*, ModelBatchCache> _modelBatchCaches;
+
+    ccstd::vector<ClipRectEntry> _clipRectStack;
+    ccstd::vector<MaskContentCheck> _maskContentChecks;
+    // content below a stencil free mask stopped supporting it, the frame is filled again with stencil
+    bool _refillFrame{false};
+
+    // weak reference, analytic masks can't be nested
+    RenderEntity* _analyticMaskEntity{nullptr};
+    // world space center and half size
+    Vec4 _analyticMaskRect;
+    // corner radius, shape, inverted
+    Vec4 _analyticMaskParams;
+    ccstd::unordered_map<ccstd::hash_t, MaterialCopyPool> _analyticMaskMaterialPools;
+    // keyed by pass hash
+    ccstd::unordered_map<ccstd::hash_t, bool> _analyticMaskSupport;
+    // weak reference, materials used below the current analytic mask
+    ccstd::unordered_map<ccstd::hash_t, Material*> _analyticMaskActiveMaterials;
+
     // weak reference
     gfx::Device* _device{nullptr}; // use getDevice()
 
@@ -117,9 +324,22 @@ private:
     UIMeshBuffer* _currMeshBuffer{nullptr};
     uint32_t _indexStart{0};
     uint32_t _currMiddlewareIbCount{0};
+
+    // Middleware draws merged into the current batch, compacted into a batch buffer if they are not contiguous.
+    ccstd::vector<MiddlewareDrawRange> _middlewareRun;
+    ccstd::hash_t _middlewareRunFormat{0};
+    uint32_t _middlewareRunVertexCount{0};
+    bool _middlewareRunIsMult{false};
+    std::array<MiddlewareTextureSlot, 8> _middlewareTextures;
+    uint32_t _middlewareTextureCount{0};
+    // manage memory manually, keyed by vertex format
+    ccstd::unordered_map<ccstd::hash_t, MiddlewareBatchBufferList> _middlewareBatchBuffers;
+    ccstd::unordered_map<ccstd::hash_t, MaterialCopyPool> _middlewareMultMaterialPools;
     ccstd::hash_t _currHash{0};
     uint32_t _currLayer{0};
     StencilStage _currStencilStage{StencilStage::DISABLED};
+    // layer of the last mask, another layer may be drawn by a camera with another stencil buffer
+    uint32_t _stencilLayer{0};
 
     // weak reference
     Material* _currMaterial{nullptr};
@@ -129,9 +349,28 @@ private:
     gfx::Sampler* _currSampler{nullptr};
     ccstd::hash_t _currSamplerHash{0};
 
+    ccstd::vector<VertexFillTask> _vertexFillTasks;
+    uint32_t _vertexFillCount{0};
+    // manage memory manually, created by getWorkers()
+    Batcher2dWorkers* _workers{nullptr};
+    // manage memory manually, keyed by weak reference
+    ccstd::unordered_map<RenderDrawInfo*, MotionStreak2D*> _motionStreaks;
+    // manage memory manually, keyed by weak reference
+    ccstd::unordered_map<RenderDrawInfo*, ParticleSimulator2D*> _particleEmitters;
+    // of the last updateParticleEmitter, the emitters are stepped once per frame with it
+    float _particleDeltaTime{0.F};
+    bool _particleEmittersUpdated{false};
+
     // weak reference
     ccstd::vector<RenderDrawInfo*> _meshRenderDrawInfo;
 
+    ccstd::vector<LocalUBOPage> _localUBOPages;
+    // in release order
+    ccstd::vector<ReleasedLocalUBO> _releasedLocalUBOs;
+    uint32_t _localUBOFrame{0};
+    // aligned size of a local UBO in floats
+    uint32_t _localUBOStride{0};
+
     // manage memory manually
     ccstd::unordered_map<ccstd::hash_t, gfx::DescriptorSet*> _descriptorSetCache;
     gfx::DescriptorSetInfo _dsInfo;
@@ -147,6 +386,7 @@ private:
 
     // Mask use
     IntrusivePtr<scene::Model> _maskClearModel;
+    IntrusivePtr<Node> _maskClearNode;
     IntrusivePtr<Material> _maskClearMtl;
     IntrusivePtr<RenderingSubMesh> _maskModelMesh;
     ccstd::vector<gfx::Attribute> _maskAttributes{
@@ -0,0 +1,107 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/renderer/Batcher2dWorkers.h"
+#include <algorithm>
+
+namespace cc {
+
+Batcher2dWorkers::Batcher2dWorkers(uint32_t threadCount) {
+    _threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        _threads.emplace_back(&Batcher2dWorkers::workerLoop, this);
+    }
+}
+
+Batcher2dWorkers::~Batcher2dWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _startCondition.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void Batcher2dWorkers::parallelFor(uint32_t count, uint32_t chunkSize, const Job& job) {
+    chunkSize = std::max(chunkSize, 1U);
+    if (_threads.empty() || count <= chunkSize) {
+        if (count > 0) {
+            job(0, count);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &job;
+        _count = count;
+        _chunkSize = chunkSize;
+        _busyWorkers = static_cast<uint32_t>(_threads.size());
+        _nextChunk.store(0, std::memory_order_relaxed);
+        ++_generation;
+    }
+    _startCondition.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _doneCondition.wait(lock, [this]() { return _busyWorkers == 0; });
+    _job = nullptr;
+}
+
+void Batcher2dWorkers::workerLoop() {
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _startCondition.wait(lock, [&]() { return _quit || _generation != generation; });
+            if (_quit) {
+                return;
+            }
+            generation = _generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_busyWorkers == 0) {
+            _doneCondition.notify_one();
+        }
+    }
+}
+
+void Batcher2dWorkers::runChunks() {
+    while (true) {
+        const uint32_t begin = _nextChunk.fetch_add(1, std::memory_order_relaxed) * _chunkSize;
+        if (begin >= _count) {
+            break;
+        }
+        (*_job)(begin, std::min(begin + _chunkSize, _count));
+    }
+}
+
+} // namespace cc
@@ -0,0 +1,75 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "base/Macros.h"
+#include "base/TypeDef.h"
+#include "base/std/container/vector.h"
+
+namespace cc {
+
+// A few threads splitting a range of independent tasks with the calling thread. Used by Batcher2d for work
+// whose writes don't overlap, so the result doesn't depend on how the range was split.
+class Batcher2dWorkers final {
+public:
+    using Job = std::function<void(uint32_t begin, uint32_t end)>;
+
+    explicit Batcher2dWorkers(uint32_t threadCount);
+    ~Batcher2dWorkers();
+
+    inline uint32_t getThreadCount() const { return static_cast<uint32_t>(_threads.size()); }
+
+    // Runs job over [0, count) in chunks of chunkSize, returns when all chunks are done.
+    void parallelFor(uint32_t count, uint32_t chunkSize, const Job& job);
+
+private:
+    CC_DISALLOW_COPY_MOVE_ASSIGN(Batcher2dWorkers);
+
+    void workerLoop();
+    void runChunks();
+
+    ccstd::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _startCondition;
+    std::condition_variable _doneCondition;
+
+    // written under _mutex before _generation changes
+    const Job* _job{nullptr};
+    uint32_t _count{0};
+    uint32_t _chunkSize{1};
+    uint32_t _busyWorkers{0};
+    uint64_t _generation{0};
+    bool _quit{false};
+
+    std::atomic<uint32_t> _nextChunk{0};
+};
+
+} // namespace cc
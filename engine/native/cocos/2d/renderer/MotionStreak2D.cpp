@@ -0,0 +1,218 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/renderer/MotionStreak2D.h"
+#include <algorithm>
+#include <cmath>
+#include "2d/renderer/RenderDrawInfo.h"
+#include "core/scene-graph/Node.h"
+
+namespace cc {
+
+namespace {
+constexpr uint32_t INITIAL_POINT_CAPACITY = 16;
+} // namespace
+
+void MotionStreak2D::setFadeTime(float fadeTime) {
+    _fadeTime = fadeTime;
+    reset();
+}
+
+void MotionStreak2D::reset() {
+    _count = 0;
+    _vertexCount = 0;
+}
+
+void MotionStreak2D::fillDrawInfo(RenderDrawInfo* drawInfo) const {
+    drawInfo->setVDataBuffer(const_cast<float*>(_vData.data()));
+    drawInfo->setIDataBuffer(const_cast<uint16_t*>(_iData.data()));
+    drawInfo->setVbCount(_vertexCount);
+    drawInfo->setIbCount(getIndexCount());
+    drawInfo->setVertDirty(true);
+}
+
+void MotionStreak2D::update(float dt) {
+    if (_node == nullptr) {
+        return;
+    }
+    if (_fadeTime <= 0.F) {
+        // nothing lives long enough to be drawn
+        reset();
+        if (_drawInfo != nullptr) {
+            fillDrawInfo(_drawInfo);
+        }
+        return;
+    }
+
+    _node->updateWorldTransform();
+    const Mat4& matrix = _node->getWorldMatrix();
+    const float tx = matrix.m[12];
+    const float ty = matrix.m[13];
+
+    // the newest point follows the node until it moved far enough
+    bool reuse = false;
+    if (_count > 1) {
+        const float difX = at(0).x - tx;
+        const float difY = at(0).y - ty;
+        reuse = difX * difX + difY * difY < _minSeg;
+    }
+    if (!reuse) {
+        pushFront();
+    }
+    StreakPoint& cur = at(0);
+    cur.x = tx;
+    cur.y = ty;
+    cur.time = _fadeTime + dt;
+
+    if (_count < 2) {
+        // the first point only, e.g. after reset
+        _vertexCount = 0;
+        if (_drawInfo != nullptr) {
+            fillDrawInfo(_drawInfo);
+        }
+        return;
+    }
+
+    StreakPoint& prev = at(1);
+    float dirX = cur.x - prev.x;
+    float dirY = cur.y - prev.y;
+    const float lengthSqr = dirX * dirX + dirY * dirY;
+    if (lengthSqr > 0.F) {
+        const float invLength = 1.F / std::sqrt(lengthSqr);
+        dirX *= invLength;
+        dirY *= invLength;
+    }
+    prev.dirX = cur.dirX = dirX;
+    prev.dirY = cur.dirY = dirY;
+
+    for (uint32_t i = 0; i < _count; i++) {
+        at(i).time -= dt;
+    }
+    // older points have less time left, the faded ones are all at the tail
+    while (_count > 0 && at(_count - 1).time < 0.F) {
+        --_count;
+    }
+    // the oldest point slides after the next one, a point without a next one is dropped
+    if (_count == 1) {
+        _count = 0;
+    } else if (_count > 1) {
+        StreakPoint& tail = at(_count - 1);
+        const StreakPoint& next = at(_count - 2);
+        const float progress = tail.time / _fadeTime;
+        tail.x = next.x - tail.dirX * progress;
+        tail.y = next.y - tail.dirY * progress;
+    }
+
+    emitVertices();
+    if (_drawInfo != nullptr) {
+        fillDrawInfo(_drawInfo);
+    }
+}
+
+void MotionStreak2D::pushFront() {
+    if (_count == MAX_POINTS) {
+        // drop the oldest point
+        --_count;
+    }
+    if (_count == _points.size()) {
+        const uint32_t capacity = std::max(INITIAL_POINT_CAPACITY, _count * 2);
+        ccstd::vector<StreakPoint> points(capacity);
+        for (uint32_t i = 0; i < _count; i++) {
+            points[i] = at(i);
+        }
+        _points.swap(points);
+        _head = 0;
+        reserveVertices(capacity);
+    }
+    _head = (_head - 1) & (static_cast<uint32_t>(_points.size()) - 1);
+    ++_count;
+}
+
+// z, u and the indices of a slot never change, they are written once
+void MotionStreak2D::reserveVertices(uint32_t pointCount) {
+    pointCount = std::min(pointCount, MAX_POINTS);
+    const auto oldPointCount = static_cast<uint32_t>(_vData.size() / (VERTEX_STRIDE * 2));
+    if (pointCount <= oldPointCount) {
+        return;
+    }
+    _vData.resize(static_cast<size_t>(pointCount) * 2 * VERTEX_STRIDE);
+    for (uint32_t i = oldPointCount * 2; i < pointCount * 2; i++) {
+        float* vertex = &_vData[static_cast<size_t>(i) * VERTEX_STRIDE];
+        vertex[2] = 0.F;
+        vertex[3] = (i % 2) == 0 ? 1.F : 0.F;
+    }
+    // a quad between each point and the next one
+    _iData.resize(static_cast<size_t>(pointCount - 1) * 6);
+    for (uint32_t i = oldPointCount > 0 ? oldPointCount - 1 : 0; i < pointCount - 1; i++) {
+        const auto start = static_cast<uint16_t>(i * 2);
+        uint16_t* index = &_iData[static_cast<size_t>(i) * 6];
+        index[0] = start;
+        index[1] = start + 2;
+        index[2] = start + 1;
+        index[3] = start + 1;
+        index[4] = start + 2;
+        index[5] = start + 3;
+    }
+}
+
+// From the oldest point to the newest, faded out towards the oldest.
+void MotionStreak2D::emitVertices() {
+    const float stroke = _stroke * 0.5F;
+    const float r = _color.r / 255.F;
+    const float g = _color.g / 255.F;
+    const float b = _color.b / 255.F;
+    const float alpha = _opacity * _color.a;
+    float* vertex = _vData.data();
+    for (uint32_t i = _count; i-- > 0;) {
+        const StreakPoint& point = at(i);
+        const float progress = point.time / _fadeTime;
+        // the perpendicular of the direction
+        const float normalX = -point.dirY * stroke;
+        const float normalY = point.dirX * stroke;
+        // stored as an integer, as Color of the assembler does
+        const float a = static_cast<float>(static_cast<int32_t>(progress * alpha)) / 255.F;
+
+        vertex[0] = point.x + normalX;
+        vertex[1] = point.y + normalY;
+        vertex[4] = progress;
+        vertex[5] = r;
+        vertex[6] = g;
+        vertex[7] = b;
+        vertex[8] = a;
+        vertex += VERTEX_STRIDE;
+
+        vertex[0] = point.x - normalX;
+        vertex[1] = point.y - normalY;
+        vertex[4] = progress;
+        vertex[5] = r;
+        vertex[6] = g;
+        vertex[7] = b;
+        vertex[8] = a;
+        vertex += VERTEX_STRIDE;
+    }
+    _vertexCount = _count * 2;
+}
+
+} // namespace cc
@@ -0,0 +1,113 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <cstdint>
+#include "base/Macros.h"
+#include "base/std/container/vector.h"
+#include "math/Color.h"
+
+namespace cc {
+
+class Node;
+class RenderDrawInfo;
+
+// The point history and the triangle strip of a MotionStreak, as motion-streak-2d-assembler.ts builds them.
+// The points live in a ring buffer, newest first, and the strip is written into vertex data kept across frames,
+// so a frame allocates nothing once the buffers are large enough for the fade time.
+class MotionStreak2D final {
+public:
+    // two vertices per point, indexed with 16 bits
+    static constexpr uint32_t MAX_POINTS = 32768;
+    static constexpr uint32_t VERTEX_STRIDE = 9;
+
+    MotionStreak2D() = default;
+    ~MotionStreak2D() = default;
+
+    // the streak follows the world position of the node
+    inline void setNode(Node* node) { _node = node; }
+    // clears the points, as setting fadeTime on the component does
+    void setFadeTime(float fadeTime);
+    inline float getFadeTime() const { return _fadeTime; }
+    // squared distance the node moves before a new point is added
+    inline void setMinSeg(float minSeg) { _minSeg = minSeg; }
+    inline float getMinSeg() const { return _minSeg; }
+    inline void setStroke(float stroke) { _stroke = stroke; }
+    inline float getStroke() const { return _stroke; }
+    inline void setColor(const Color& color) { _color = color; }
+    // of the node, multiplied into the alpha of the color
+    inline void setOpacity(float opacity) { _opacity = opacity; }
+    // filled with the strip after each update
+    inline void setDrawInfo(RenderDrawInfo* drawInfo) { _drawInfo = drawInfo; }
+
+    void reset();
+    // in place of MotionStreakAssembler.update, from lateUpdate
+    void update(float dt);
+
+    inline uint32_t getPointCount() const { return _count; }
+    inline uint32_t getVertexCount() const { return _vertexCount; }
+    inline uint32_t getIndexCount() const { return _vertexCount <= 2 ? 0 : (_vertexCount - 2) * 3; }
+    // world positions, x, y, z, u, v, r, g, b, a per vertex
+    inline const float* getVData() const { return _vData.data(); }
+    inline const uint16_t* getIData() const { return _iData.data(); }
+    void fillDrawInfo(RenderDrawInfo* drawInfo) const;
+
+private:
+    CC_DISALLOW_COPY_MOVE_ASSIGN(MotionStreak2D);
+
+    struct StreakPoint {
+        float x{0.F};
+        float y{0.F};
+        float dirX{0.F};
+        float dirY{0.F};
+        float time{0.F};
+    };
+
+    // 0 is the newest point
+    inline StreakPoint& at(uint32_t index) { return _points[(_head + index) & (_points.size() - 1)]; }
+    void pushFront();
+    void reserveVertices(uint32_t pointCount);
+    void emitVertices();
+
+    Node* _node{nullptr};
+    RenderDrawInfo* _drawInfo{nullptr};
+    float _fadeTime{1.F};
+    float _minSeg{1.F};
+    float _stroke{64.F};
+    Color _color{255, 255, 255, 255};
+    float _opacity{1.F};
+
+    // power of two sized ring
+    ccstd::vector<StreakPoint> _points;
+    uint32_t _head{0};
+    uint32_t _count{0};
+
+    ccstd::vector<float> _vData;
+    ccstd::vector<uint16_t> _iData;
+    uint32_t _vertexCount{0};
+};
+
+} // namespace cc
@@ -0,0 +1,226 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/renderer/ParticleManager2D.h"
+
+#include <algorithm>
+#include "2d/renderer/RenderDrawInfo.h"
+#include "base/Log.h"
+
+namespace cc {
+
+namespace {
+ParticleManager2D* instance = nullptr;
+} // namespace
+
+ParticleManager2D* ParticleManager2D::getInstance() {
+    if (instance == nullptr) {
+        instance = new ParticleManager2D();
+    }
+    return instance;
+}
+
+void ParticleManager2D::destroyInstance() {
+    delete instance;
+    instance = nullptr;
+}
+
+ParticleManager2D::~ParticleManager2D() {
+    for (auto* simulator : _simulators) {
+        simulator->_registered = false;
+    }
+}
+
+void ParticleManager2D::addSimulator(ParticleSimulator2D* simulator) {
+    if (simulator->_registered) {
+        return;
+    }
+    simulator->_registered = true;
+    _simulators.push_back(simulator);
+}
+
+void ParticleManager2D::removeSimulator(ParticleSimulator2D* simulator) {
+    auto iter = std::find(_simulators.begin(), _simulators.end(), simulator);
+    if (iter == _simulators.end()) {
+        return;
+    }
+    simulator->_registered = false;
+    simulator->_emissionScale = 1.F;
+    simulator->_culled = false;
+    *iter = _simulators.back();
+    _simulators.pop_back();
+    // removed by the finished callback of another emitter
+    std::replace(_stepping.begin(), _stepping.end(), simulator, static_cast<ParticleSimulator2D*>(nullptr));
+}
+
+uint32_t ParticleManager2D::getParticleCount() const {
+    uint32_t count = 0;
+    for (const auto* simulator : _simulators) {
+        count += simulator->getParticleCount();
+    }
+    return count;
+}
+
+void ParticleManager2D::setViewRect(float left, float bottom, float right, float top) { // NOLINT(bugprone-easily-swappable-parameters)
+    _viewLeft = left;
+    _viewBottom = bottom;
+    _viewRight = right;
+    _viewTop = top;
+    _hasViewRect = true;
+}
+
+void ParticleManager2D::update(float dt, Batcher2dWorkers* workers) {
+    applyBudget();
+    _stepping.clear();
+    uint32_t particleCount = 0;
+    for (auto* simulator : _simulators) {
+        if (simulator->isFinished()) {
+            continue;
+        }
+        simulator->beginStep();
+        if (!prepareStep(simulator, dt)) {
+            continue;
+        }
+        _stepping.push_back(simulator);
+        particleCount += simulator->getParticleCount();
+    }
+
+    const auto job = [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            _stepping[i]->simulate(_stepping[i]->_stepTime, _stepping[i]->_skippedTime);
+        }
+    };
+    const auto count = static_cast<uint32_t>(_stepping.size());
+    if (workers != nullptr && particleCount >= PARALLEL_MIN_PARTICLES && count > 1) {
+        workers->parallelFor(count, 1, job);
+    } else {
+        job(0, count);
+    }
+
+    // the callbacks may remove simulators, the list stepped is a copy
+    for (uint32_t i = 0; i < count; i++) {
+        if (_stepping[i] != nullptr) {
+            _stepping[i]->endStep();
+        }
+    }
+}
+
+ParticleManager2DStats ParticleManager2D::getStats() const {
+    ParticleManager2DStats stats;
+    stats.emitterCount = static_cast<uint32_t>(_simulators.size());
+    for (const auto* simulator : _stepping) {
+        if (simulator != nullptr) {
+            ++stats.steppedCount;
+            stats.stepCost += simulator->getStepCost();
+        }
+    }
+    for (const auto* simulator : _simulators) {
+        stats.particleCount += simulator->getParticleCount();
+        stats.culledCount += simulator->isCulled() ? 1 : 0;
+        stats.scaledCount += simulator->getEmissionScale() < 1.F ? 1 : 0;
+    }
+    return stats;
+}
+
+void ParticleManager2D::printStats() const {
+    const auto stats = getStats();
+    CC_LOG_INFO("ParticleManager2D: %u emitters, %u stepped, %u culled, %u scaled by the budget, %u particles of %u, %.1f us",
+                stats.emitterCount, stats.steppedCount, stats.culledCount, stats.scaledCount, stats.particleCount, _maxParticles, stats.stepCost);
+    ccstd::vector<const ParticleSimulator2D*> simulators(_simulators.begin(), _simulators.end());
+    std::sort(simulators.begin(), simulators.end(), [](const ParticleSimulator2D* a, const ParticleSimulator2D* b) {
+        return a->getStepCost() > b->getStepCost();
+    });
+    for (const auto* simulator : simulators) {
+        CC_LOG_INFO("  %s: priority %d, %u particles, emission x%.2f%s, %.1f us", simulator->getName().c_str(), simulator->getPriority(),
+                    simulator->getParticleCount(), simulator->getEmissionScale(), simulator->isCulled() ? ", culled" : "", simulator->getStepCost());
+    }
+}
+
+// By priority, every emitter of a priority gets the same share of what the higher priorities left.
+void ParticleManager2D::applyBudget() {
+    if (_maxParticles == 0) {
+        for (auto* simulator : _simulators) {
+            simulator->_emissionScale = 1.F;
+        }
+        return;
+    }
+    _budgetOrder.assign(_simulators.begin(), _simulators.end());
+    std::stable_sort(_budgetOrder.begin(), _budgetOrder.end(), [](const ParticleSimulator2D* a, const ParticleSimulator2D* b) {
+        return a->getPriority() > b->getPriority();
+    });
+    auto remaining = static_cast<float>(_maxParticles);
+    size_t begin = 0;
+    while (begin < _budgetOrder.size()) {
+        // an emitter which stopped emitting only holds its live particles
+        float demand = 0.F;
+        size_t end = begin;
+        for (; end < _budgetOrder.size() && _budgetOrder[end]->getPriority() == _budgetOrder[begin]->getPriority(); end++) {
+            const auto* simulator = _budgetOrder[end];
+            demand += static_cast<float>(simulator->isActive() ? simulator->getConfig().totalParticles : simulator->getParticleCount());
+        }
+        const float scale = demand <= remaining ? 1.F : remaining / demand;
+        for (size_t i = begin; i < end; i++) {
+            _budgetOrder[i]->_emissionScale = scale;
+        }
+        remaining = std::max(remaining - demand, 0.F);
+        begin = end;
+    }
+}
+
+bool ParticleManager2D::isCulled(const ParticleSimulator2D* simulator) const {
+    if (simulator->getCulling() == ParticleCulling2D::NONE) {
+        return false;
+    }
+    return simulator->getOpacity() <= 0.F || (_hasViewRect && !simulator->intersects(_viewLeft, _viewBottom, _viewRight, _viewTop));
+}
+
+bool ParticleManager2D::prepareStep(ParticleSimulator2D* simulator, float dt) const {
+    const float frameTime = simulator->clampDeltaTime(dt);
+    simulator->_culled = isCulled(simulator);
+    const bool throttled = simulator->_culled && simulator->getCulling() == ParticleCulling2D::THROTTLE;
+    if (simulator->_culled && !throttled) {
+        if (simulator->isCatchUp()) {
+            simulator->_pendingTime = std::min(simulator->_pendingTime + frameTime, simulator->getMaxLife());
+        }
+        // paused, the particles are kept but not drawn
+        if (simulator->_drawInfo != nullptr) {
+            simulator->_drawInfo->setVbCount(0);
+            simulator->_drawInfo->setIbCount(0);
+        }
+        return false;
+    }
+    if (throttled && ++simulator->_throttleFrame < THROTTLE_INTERVAL) {
+        simulator->_pendingTime += frameTime;
+        return false;
+    }
+    // the time left from throttling or to catch up on is simulated before the frame
+    simulator->_stepTime = frameTime;
+    simulator->_skippedTime = simulator->_pendingTime;
+    simulator->_pendingTime = 0.F;
+    simulator->_throttleFrame = 0;
+    return true;
+}
+
+} // namespace cc
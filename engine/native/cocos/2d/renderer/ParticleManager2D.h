@@ -0,0 +1,105 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#pragma once
+
+#include "2d/renderer/Batcher2dWorkers.h"
+#include "2d/renderer/ParticleSimulator2D.h"
+#include "base/Macros.h"
+#include "base/std/container/vector.h"
+
+namespace cc {
+
+struct ParticleManager2DStats {
+    uint32_t emitterCount{0};
+    uint32_t steppedCount{0};
+    uint32_t culledCount{0};
+    uint32_t particleCount{0};
+    // emitters emitting less than configured because of the budget
+    uint32_t scaledCount{0};
+    // sum of the step costs of the emitters stepped in the last frame
+    float stepCost{0.F};
+};
+
+// Steps the native ParticleSystem2D emitters together, once per frame. The emitters are split between the
+// worker threads of Batcher2d when there are enough particles, each emitter only writes its own arrays and vertices.
+// Emitters outside of the view rect or fully transparent are throttled or paused as their culling mode says.
+// With a particle budget, the emission of the lowest priorities is scaled down until the total particles of
+// all emitters fit. Live particles are never killed, the count falls under the budget as they expire.
+class ParticleManager2D final {
+public:
+    static constexpr uint32_t PARALLEL_MIN_PARTICLES = 4096;
+    // culled emitters with ParticleCulling2D::THROTTLE are stepped once every THROTTLE_INTERVAL frames
+    static constexpr uint32_t THROTTLE_INTERVAL = 4;
+
+    static ParticleManager2D* getInstance();
+    // Called by ~Batcher2d, the simulators left are unregistered.
+    static void destroyInstance();
+    ParticleManager2D() = default;
+    ~ParticleManager2D();
+
+    void addSimulator(ParticleSimulator2D* simulator);
+    void removeSimulator(ParticleSimulator2D* simulator);
+    inline uint32_t getSimulatorCount() const { return static_cast<uint32_t>(_simulators.size()); }
+    uint32_t getParticleCount() const;
+
+    // the visible world rect, e.g. of the 2D camera; without one only the opacity culls
+    void setViewRect(float left, float bottom, float right, float top); // NOLINT(bugprone-easily-swappable-parameters)
+    inline void clearViewRect() { _hasViewRect = false; }
+    // the most particles emitted by all emitters together, 0 for no limit
+    inline void setMaxParticles(uint32_t maxParticles) { _maxParticles = maxParticles; }
+    inline uint32_t getMaxParticles() const { return _maxParticles; }
+
+    // Called by Batcher2d::update before the walk with Batcher2d::getWorkers(), or nullptr to step every emitter on
+    // the calling thread. Finished emitters are skipped, as ParticleSystem2D does, their callbacks run on the calling
+    // thread.
+    void update(float dt, Batcher2dWorkers* workers);
+
+    ParticleManager2DStats getStats() const;
+    // the totals, then the cost of each emitter, most expensive first
+    void printStats() const;
+
+private:
+    CC_DISALLOW_COPY_MOVE_ASSIGN(ParticleManager2D);
+
+    void applyBudget();
+    bool isCulled(const ParticleSimulator2D* simulator) const;
+    // false if the simulator is skipped in this frame
+    bool prepareStep(ParticleSimulator2D* simulator, float dt) const;
+
+    ccstd::vector<ParticleSimulator2D*> _simulators;
+    // stepped this frame
+    ccstd::vector<ParticleSimulator2D*> _stepping;
+    // sorted by priority for the budget
+    ccstd::vector<ParticleSimulator2D*> _budgetOrder;
+    uint32_t _maxParticles{0};
+    float _viewLeft{0.F};
+    float _viewBottom{0.F};
+    float _viewRight{0.F};
+    float _viewTop{0.F};
+    bool _hasViewRect{false};
+};
+
+} // namespace cc
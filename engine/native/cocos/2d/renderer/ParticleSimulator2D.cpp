@@ -0,0 +1,514 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/renderer/ParticleSimulator2D.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "2d/renderer/ParticleManager2D.h"
+#include "2d/renderer/RenderDrawInfo.h"
+#include "core/scene-graph/Node.h"
+
+namespace cc {
+
+namespace {
+constexpr float DEG_TO_RAD = 3.14159265358979323846F / 180.F;
+constexpr float RAD_TO_DEG = 180.F / 3.14159265358979323846F;
+// time skipped by throttling or pausing is simulated in substeps of this length at most, emitting on each of them
+constexpr float SUBSTEP_TIME = 1.F / 30.F;
+
+// color channels are stored as integers, as Color of the script simulator does
+inline float clampColor(float value) {
+    // the conversion vectorizes where truncf may not
+    return static_cast<float>(static_cast<int32_t>(std::min(std::max(value, 0.F), 255.F)));
+}
+} // namespace
+
+ParticleSimulator2D::ParticleSimulator2D() {
+    reserve(_config.totalParticles);
+}
+
+ParticleSimulator2D::~ParticleSimulator2D() {
+    if (_registered) {
+        ParticleManager2D::getInstance()->removeSimulator(this);
+    }
+}
+
+void ParticleSimulator2D::setConfig(const ParticleEmitterConfig2D& config) {
+    _config = config;
+    _config.totalParticles = std::min(_config.totalParticles, MAX_PARTICLES);
+    if (_config.totalParticles > _capacity) {
+        reserve(_config.totalParticles);
+    }
+}
+
+void ParticleSimulator2D::setUVs(const float* uvs) {
+    if (std::memcmp(_uvs, uvs, sizeof(_uvs)) == 0) {
+        return;
+    }
+    std::memcpy(_uvs, uvs, sizeof(_uvs));
+    // every quad samples the same frame, written once for all of them
+    float* vertex = _vData.data();
+    for (uint32_t i = 0; i < _capacity * 4; i++, vertex += VERTEX_STRIDE) {
+        vertex[3] = _uvs[(i % 4) * 2];
+        vertex[4] = _uvs[(i % 4) * 2 + 1];
+    }
+}
+
+void ParticleSimulator2D::reset() {
+    _active = true;
+    _readyToPlay = true;
+    _elapsed = 0.F;
+    _emitCounter = 0.F;
+    _finished = false;
+    _finishPending = false;
+    _count = 0;
+    _pendingTime = 0.F;
+    _throttleFrame = 0;
+}
+
+void ParticleSimulator2D::stop() {
+    _active = false;
+    _readyToPlay = false;
+    _elapsed = _config.duration;
+    _emitCounter = 0.F;
+}
+
+void ParticleSimulator2D::step(float dt) {
+    beginStep();
+    simulate(clampDeltaTime(dt), 0.F);
+    endStep();
+}
+
+void ParticleSimulator2D::fillDrawInfo(RenderDrawInfo* drawInfo) const {
+    drawInfo->setVDataBuffer(const_cast<float*>(_vData.data()));
+    drawInfo->setIDataBuffer(const_cast<uint16_t*>(_iData.data()));
+    drawInfo->setVbCount(_count * 4);
+    drawInfo->setIbCount(_count * 6);
+    drawInfo->setVertDirty(true);
+}
+
+void ParticleSimulator2D::beginStep() {
+    if (_node == nullptr) {
+        return;
+    }
+    _node->updateWorldTransform();
+    if (_config.positionType == ParticlePositionType2D::FREE) {
+        // the rotation of the emitter in the world
+        _worldRotation = 0.F;
+        for (const Node* node = _node; node != nullptr; node = node->getParent()) {
+            _worldRotation += node->getEulerAngles().z;
+        }
+        const Mat4& matrix = _node->getWorldMatrix();
+        _emitterX = matrix.m[12];
+        _emitterY = matrix.m[13];
+    } else if (_config.positionType == ParticlePositionType2D::RELATIVE) {
+        _worldRotation = _node->getEulerAngles().z;
+        _emitterX = _node->getPosition().x;
+        _emitterY = _node->getPosition().y;
+    } else {
+        _worldRotation = 0.F;
+    }
+}
+
+float ParticleSimulator2D::clampDeltaTime(float dt) const {
+    return _config.maxDeltaTime > 0.F ? std::min(dt, _config.maxDeltaTime) : dt;
+}
+
+void ParticleSimulator2D::simulate(float dt, float skippedTime) {
+    const auto start = std::chrono::steady_clock::now();
+    // older than the frame, bounded by the throttle interval or the longest particle life
+    if (skippedTime > 0.F) {
+        const auto steps = static_cast<uint32_t>(std::ceil(skippedTime / SUBSTEP_TIME));
+        for (uint32_t i = 0; i < steps; i++) {
+            simulateStep(skippedTime / static_cast<float>(steps));
+        }
+    }
+    simulateStep(dt);
+    fillVertices();
+    if (_count == 0 && !_active && !_readyToPlay && !_finished) {
+        _finished = true;
+        _finishPending = true;
+    }
+    _stepCost = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParticleSimulator2D::simulateStep(float dt) {
+    emit(dt);
+    integrate(dt);
+    removeDead();
+}
+
+float ParticleSimulator2D::getMaxLife() const {
+    return std::max(0.F, _config.life + std::abs(_config.lifeVar));
+}
+
+bool ParticleSimulator2D::intersects(float left, float bottom, float right, float top) const {
+    // the area new particles appear in, in the space of the vertices
+    const bool grouped = _config.positionType == ParticlePositionType2D::GROUPED;
+    const float extent = std::max(_config.startSize + std::abs(_config.startSizeVar), 0.F) * 0.5F;
+    const float emitterX = (grouped ? 0.F : _emitterX) + _config.sourcePos.x;
+    const float emitterY = (grouped ? 0.F : _emitterY) + _config.sourcePos.y;
+    float minX = emitterX - std::abs(_config.posVar.x) - extent;
+    float minY = emitterY - std::abs(_config.posVar.y) - extent;
+    float maxX = emitterX + std::abs(_config.posVar.x) + extent;
+    float maxY = emitterY + std::abs(_config.posVar.y) + extent;
+    if (_count > 0) {
+        minX = std::min(minX, _boundsMinX);
+        minY = std::min(minY, _boundsMinY);
+        maxX = std::max(maxX, _boundsMaxX);
+        maxY = std::max(maxY, _boundsMaxY);
+    }
+
+    // free particles are in the world, relative ones in the parent, grouped ones in the node
+    const Node* space = nullptr;
+    if (_node != nullptr && _config.positionType == ParticlePositionType2D::RELATIVE) {
+        space = _node->getParent();
+    } else if (_node != nullptr && grouped) {
+        space = _node;
+    }
+    if (space != nullptr) {
+        const float* m = space->getWorldMatrix().m;
+        const float centerX = (minX + maxX) * 0.5F;
+        const float centerY = (minY + maxY) * 0.5F;
+        const float halfX = (maxX - minX) * 0.5F;
+        const float halfY = (maxY - minY) * 0.5F;
+        const float worldX = m[0] * centerX + m[4] * centerY + m[12];
+        const float worldY = m[1] * centerX + m[5] * centerY + m[13];
+        const float worldHalfX = std::abs(m[0]) * halfX + std::abs(m[4]) * halfY;
+        const float worldHalfY = std::abs(m[1]) * halfX + std::abs(m[5]) * halfY;
+        minX = worldX - worldHalfX;
+        minY = worldY - worldHalfY;
+        maxX = worldX + worldHalfX;
+        maxY = worldY + worldHalfY;
+    }
+    return minX <= right && maxX >= left && minY <= top && maxY >= bottom;
+}
+
+void ParticleSimulator2D::endStep() {
+    if (_drawInfo != nullptr) {
+        fillDrawInfo(_drawInfo);
+    }
+    if (_finishPending) {
+        _finishPending = false;
+        if (_finishedCallback) {
+            _finishedCallback();
+        }
+    }
+}
+
+void ParticleSimulator2D::reserve(uint32_t capacity) {
+    const uint32_t oldCapacity = _capacity;
+    ccstd::vector<float> streams(static_cast<size_t>(capacity) * STREAM_COUNT);
+    for (uint32_t s = 0; s < STREAM_COUNT && _count > 0; s++) {
+        std::memcpy(&streams[static_cast<size_t>(s) * capacity], &_streams[static_cast<size_t>(s) * oldCapacity], _count * sizeof(float));
+    }
+    _streams.swap(streams);
+    _capacity = capacity;
+    _rotationScratch.resize(static_cast<size_t>(capacity) * 2);
+
+    _vData.resize(static_cast<size_t>(capacity) * 4 * VERTEX_STRIDE);
+    float* vertex = _vData.data() + static_cast<size_t>(oldCapacity) * 4 * VERTEX_STRIDE;
+    for (uint32_t i = oldCapacity * 4; i < capacity * 4; i++, vertex += VERTEX_STRIDE) {
+        vertex[2] = 0.F;
+        vertex[3] = _uvs[(i % 4) * 2];
+        vertex[4] = _uvs[(i % 4) * 2 + 1];
+    }
+    _iData.resize(static_cast<size_t>(capacity) * 6);
+    for (uint32_t i = oldCapacity; i < capacity; i++) {
+        const auto vId = static_cast<uint16_t>(i * 4);
+        uint16_t* index = &_iData[static_cast<size_t>(i) * 6];
+        index[0] = vId;
+        index[1] = vId + 1;
+        index[2] = vId + 2;
+        index[3] = vId + 1;
+        index[4] = vId + 3;
+        index[5] = vId + 2;
+    }
+    // the draw info still points at the old data
+    if (_drawInfo != nullptr) {
+        fillDrawInfo(_drawInfo);
+    }
+}
+
+void ParticleSimulator2D::emit(float dt) {
+    if (!_active || _config.emissionRate == 0.F) {
+        return;
+    }
+    // the budget thins the emission out evenly rather than cutting it off
+    const auto total = std::min(static_cast<uint32_t>(std::ceil(static_cast<float>(_config.totalParticles) * _emissionScale)), _capacity);
+    if (total > 0) {
+        const float rate = 1.F / (_config.emissionRate * _emissionScale);
+        // prevent bursts of particles, due to too high emitCounter
+        if (_count < total) {
+            _emitCounter += dt;
+        }
+        while (_count < total && _emitCounter > rate) {
+            emitParticle();
+            _emitCounter -= rate;
+        }
+    }
+    _elapsed += dt;
+    if (_config.duration != ParticleEmitterConfig2D::DURATION_INFINITY && _config.duration < _elapsed) {
+        stop();
+    }
+}
+
+void ParticleSimulator2D::emitParticle() {
+    const auto& c = _config;
+    const uint32_t i = _count++;
+
+    // no negative life, prevent division by 0
+    const float timeToLive = std::max(0.F, c.life + c.lifeVar * randomMinus1To1());
+    stream(TIME_TO_LIVE)[i] = timeToLive;
+
+    stream(POS_X)[i] = c.sourcePos.x + c.posVar.x * randomMinus1To1();
+    stream(POS_Y)[i] = c.sourcePos.y + c.posVar.y * randomMinus1To1();
+
+    const float startColor[4] = {
+        clampColor(c.startColor.r + c.startColorVar.r * randomMinus1To1()),
+        clampColor(c.startColor.g + c.startColorVar.g * randomMinus1To1()),
+        clampColor(c.startColor.b + c.startColorVar.b * randomMinus1To1()),
+        clampColor(c.startColor.a + c.startColorVar.a * randomMinus1To1()),
+    };
+    const float endColor[4] = {
+        std::min(std::max(c.endColor.r + c.endColorVar.r * randomMinus1To1(), 0.F), 255.F),
+        std::min(std::max(c.endColor.g + c.endColorVar.g * randomMinus1To1(), 0.F), 255.F),
+        std::min(std::max(c.endColor.b + c.endColorVar.b * randomMinus1To1(), 0.F), 255.F),
+        std::min(std::max(c.endColor.a + c.endColorVar.a * randomMinus1To1(), 0.F), 255.F),
+    };
+    for (uint32_t k = 0; k < 4; k++) {
+        stream(static_cast<Stream>(COLOR_R + k))[i] = startColor[k];
+        stream(static_cast<Stream>(DELTA_COLOR_R + k))[i] = (endColor[k] - startColor[k]) / timeToLive;
+    }
+
+    const float startSize = std::max(0.F, c.startSize + c.startSizeVar * randomMinus1To1());
+    stream(SIZE)[i] = startSize;
+    if (c.endSize == ParticleEmitterConfig2D::START_SIZE_EQUAL_TO_END_SIZE) {
+        stream(DELTA_SIZE)[i] = 0.F;
+    } else {
+        const float endSize = std::max(0.F, c.endSize + c.endSizeVar * randomMinus1To1());
+        stream(DELTA_SIZE)[i] = (endSize - startSize) / timeToLive;
+    }
+
+    const float startSpin = c.startSpin + c.startSpinVar * randomMinus1To1();
+    const float endSpin = c.endSpin + c.endSpinVar * randomMinus1To1();
+    stream(ROTATION)[i] = startSpin;
+    stream(DELTA_ROTATION)[i] = (endSpin - startSpin) / timeToLive;
+
+    stream(START_POS_X)[i] = _emitterX;
+    stream(START_POS_Y)[i] = _emitterY;
+    stream(ASPECT_RATIO)[i] = c.aspectRatio != 0.F ? c.aspectRatio : 1.F;
+
+    const float a = (c.angle + _worldRotation + c.angleVar * randomMinus1To1()) * DEG_TO_RAD;
+    if (c.emitterMode == ParticleEmitterMode2D::GRAVITY) {
+        const float s = c.speed + c.speedVar * randomMinus1To1();
+        const float dirX = std::cos(a) * s;
+        const float dirY = std::sin(a) * s;
+        stream(MODE_0)[i] = dirX;
+        stream(MODE_1)[i] = dirY;
+        stream(MODE_2)[i] = c.radialAccel + c.radialAccelVar * randomMinus1To1();
+        stream(MODE_3)[i] = c.tangentialAccel + c.tangentialAccelVar * randomMinus1To1();
+        if (c.rotationIsDir) {
+            stream(ROTATION)[i] = -std::atan2(dirY, dirX) * RAD_TO_DEG;
+        }
+    } else {
+        // the default diameter of the particle from the source position
+        const float startRadius = c.startRadius + c.startRadiusVar * randomMinus1To1();
+        const float endRadius = c.endRadius + c.endRadiusVar * randomMinus1To1();
+        stream(MODE_0)[i] = a;
+        stream(MODE_1)[i] = (c.rotatePerS + c.rotatePerSVar * randomMinus1To1()) * DEG_TO_RAD;
+        stream(MODE_2)[i] = startRadius;
+        stream(MODE_3)[i] = c.endRadius == ParticleEmitterConfig2D::START_RADIUS_EQUAL_TO_END_RADIUS ? 0.F : (endRadius - startRadius) / timeToLive;
+    }
+}
+
+// Dead particles are updated too, the loops have no branches and are removed right after.
+void ParticleSimulator2D::integrate(float dt) {
+    const uint32_t count = _count;
+    float* timeToLive = stream(TIME_TO_LIVE);
+    float* posX = stream(POS_X);
+    float* posY = stream(POS_Y);
+    float* mode0 = stream(MODE_0);
+    float* mode1 = stream(MODE_1);
+    float* mode2 = stream(MODE_2);
+    float* mode3 = stream(MODE_3);
+
+    for (uint32_t i = 0; i < count; i++) {
+        timeToLive[i] -= dt;
+    }
+
+    if (_config.emitterMode == ParticleEmitterMode2D::GRAVITY) {
+        const float gravityX = _config.gravity.x;
+        const float gravityY = _config.gravity.y;
+        for (uint32_t i = 0; i < count; i++) {
+            // radial acceleration along the normalized position, tangential acceleration perpendicular to it
+            const float x = posX[i];
+            const float y = posY[i];
+            const float lengthSqr = x * x + y * y;
+            const float invLength = lengthSqr > 0.F ? 1.F / std::sqrt(lengthSqr) : 0.F;
+            const float radialX = x * invLength;
+            const float radialY = y * invLength;
+            const float accelX = radialX * mode2[i] - radialY * mode3[i] + gravityX;
+            const float accelY = radialY * mode2[i] + radialX * mode3[i] + gravityY;
+            mode0[i] += accelX * dt;
+            mode1[i] += accelY * dt;
+            posX[i] = x + mode0[i] * dt;
+            posY[i] = y + mode1[i] * dt;
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            mode0[i] += mode1[i] * dt;
+            mode2[i] += mode3[i] * dt;
+            posX[i] = -std::cos(mode0[i]) * mode2[i];
+            posY[i] = -std::sin(mode0[i]) * mode2[i];
+        }
+    }
+
+    for (uint32_t k = 0; k < 4; k++) {
+        float* color = stream(static_cast<Stream>(COLOR_R + k));
+        const float* deltaColor = stream(static_cast<Stream>(DELTA_COLOR_R + k));
+        for (uint32_t i = 0; i < count; i++) {
+            color[i] = clampColor(color[i] + deltaColor[i] * dt);
+        }
+    }
+
+    float* size = stream(SIZE);
+    const float* deltaSize = stream(DELTA_SIZE);
+    float* rotation = stream(ROTATION);
+    const float* deltaRotation = stream(DELTA_ROTATION);
+    for (uint32_t i = 0; i < count; i++) {
+        size[i] = std::max(0.F, size[i] + deltaSize[i] * dt);
+        rotation[i] += deltaRotation[i] * dt;
+    }
+}
+
+// Swaps the last live particle into each dead one, as the script simulator does.
+void ParticleSimulator2D::removeDead() {
+    const float* timeToLive = stream(TIME_TO_LIVE);
+    uint32_t i = 0;
+    while (i < _count) {
+        if (timeToLive[i] > 0.F) {
+            ++i;
+            continue;
+        }
+        const uint32_t last = --_count;
+        if (i != last) {
+            for (uint32_t s = 0; s < STREAM_COUNT; s++) {
+                float* values = stream(static_cast<Stream>(s));
+                values[i] = values[last];
+            }
+        }
+    }
+}
+
+void ParticleSimulator2D::fillVertices() {
+    const uint32_t count = _count;
+    const bool grouped = _config.positionType == ParticlePositionType2D::GROUPED;
+    const float* posX = stream(POS_X);
+    const float* posY = stream(POS_Y);
+    const float* startPosX = stream(START_POS_X);
+    const float* startPosY = stream(START_POS_Y);
+    const float* size = stream(SIZE);
+    const float* aspectRatio = stream(ASPECT_RATIO);
+    const float* rotation = stream(ROTATION);
+    const float* colorR = stream(COLOR_R);
+    const float* colorG = stream(COLOR_G);
+    const float* colorB = stream(COLOR_B);
+    const float* colorA = stream(COLOR_A);
+    float* vData = _vData.data();
+
+    // the trigonometry is kept out of the vertex loop, unrotated quads skip it: cos 1 and sin 0 give the same corners
+    float* cosRotation = _rotationScratch.data();
+    float* sinRotation = cosRotation + _capacity;
+    for (uint32_t i = 0; i < count; i++) {
+        cosRotation[i] = 1.F;
+        sinRotation[i] = 0.F;
+        if (rotation[i] != 0.F) {
+            const float rad = -rotation[i] * DEG_TO_RAD;
+            cosRotation[i] = std::cos(rad);
+            sinRotation[i] = std::sin(rad);
+        }
+    }
+
+    constexpr float INV_255 = 1.F / 255.F;
+    float minX = 0.F;
+    float minY = 0.F;
+    float maxX = 0.F;
+    float maxY = 0.F;
+    if (count > 0) {
+        minX = maxX = grouped ? posX[0] : posX[0] + startPosX[0];
+        minY = maxY = grouped ? posY[0] : posY[0] + startPosY[0];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const float x = grouped ? posX[i] : posX[i] + startPosX[i];
+        const float y = grouped ? posY[i] : posY[i] + startPosY[i];
+        const float width = aspectRatio[i] > 1.F ? size[i] : size[i] * aspectRatio[i];
+        const float height = aspectRatio[i] > 1.F ? size[i] / aspectRatio[i] : size[i];
+        const float halfWidth = width * 0.5F;
+        const float halfHeight = height * 0.5F;
+        const float cr = cosRotation[i];
+        const float sr = sinRotation[i];
+        const float corners[8] = {-halfWidth, -halfHeight, halfWidth, -halfHeight, -halfWidth, halfHeight, halfWidth, halfHeight};
+        const float r = colorR[i] * INV_255;
+        const float g = colorG[i] * INV_255;
+        const float b = colorB[i] * INV_255;
+        const float a = colorA[i] * INV_255;
+
+        float* vertex = vData + static_cast<size_t>(i) * 4 * VERTEX_STRIDE;
+        for (uint32_t k = 0; k < 4; k++, vertex += VERTEX_STRIDE) {
+            const float cx = corners[k * 2];
+            const float cy = corners[k * 2 + 1];
+            vertex[0] = cx * cr - cy * sr + x;
+            vertex[1] = cx * sr + cy * cr + y;
+            minX = std::min(minX, vertex[0]);
+            minY = std::min(minY, vertex[1]);
+            maxX = std::max(maxX, vertex[0]);
+            maxY = std::max(maxY, vertex[1]);
+            vertex[5] = r;
+            vertex[6] = g;
+            vertex[7] = b;
+            vertex[8] = a;
+        }
+    }
+    _boundsMinX = minX;
+    _boundsMinY = minY;
+    _boundsMaxX = maxX;
+    _boundsMaxY = maxY;
+}
+
+// xorshift32, every emitter draws from its own generator so they can be stepped on any thread
+float ParticleSimulator2D::random() {
+    uint32_t x = _random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _random = x;
+    return static_cast<float>(x >> 8) * (1.F / 16777216.F);
+}
+
+} // namespace cc
@@ -0,0 +1,287 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "base/Macros.h"
+#include "base/std/container/string.h"
+#include "base/std/container/vector.h"
+#include "math/Color.h"
+#include "math/Vec2.h"
+
+namespace cc {
+
+class Node;
+class RenderDrawInfo;
+
+// Same values as EmitterMode and PositionType of particle-2d/define.ts.
+enum class ParticleEmitterMode2D : uint8_t {
+    GRAVITY,
+    RADIUS,
+};
+
+enum class ParticlePositionType2D : uint8_t {
+    FREE,
+    RELATIVE,
+    GROUPED,
+};
+
+// What an emitter does while it is outside of the view of ParticleManager2D or fully transparent.
+enum class ParticleCulling2D : uint8_t {
+    // simulated every frame
+    NONE,
+    // simulated every few frames, with the time of the frames skipped
+    THROTTLE,
+    // not simulated nor drawn, optionally catching up on the time skipped when visible again; doesn't finish while paused
+    PAUSE,
+};
+
+// The emitter properties of ParticleSystem2D read by the simulator, angles in degrees.
+struct ParticleEmitterConfig2D {
+    static constexpr float DURATION_INFINITY = -1.F;
+    static constexpr float START_SIZE_EQUAL_TO_END_SIZE = -1.F;
+    static constexpr float START_RADIUS_EQUAL_TO_END_RADIUS = -1.F;
+
+    ParticleEmitterMode2D emitterMode{ParticleEmitterMode2D::GRAVITY};
+    ParticlePositionType2D positionType{ParticlePositionType2D::FREE};
+    uint32_t totalParticles{150};
+    float emissionRate{10.F};
+    float duration{DURATION_INFINITY};
+    // the longest step simulated at once, 0 for no limit
+    float maxDeltaTime{0.F};
+
+    float life{1.F};
+    float lifeVar{0.F};
+    Vec2 sourcePos;
+    Vec2 posVar;
+    float angle{90.F};
+    float angleVar{20.F};
+    Color startColor{255, 255, 255, 255};
+    Color startColorVar{0, 0, 0, 0};
+    Color endColor{255, 255, 255, 0};
+    Color endColorVar{0, 0, 0, 0};
+    float startSize{50.F};
+    float startSizeVar{0.F};
+    float endSize{0.F};
+    float endSizeVar{0.F};
+    float startSpin{0.F};
+    float startSpinVar{0.F};
+    float endSpin{0.F};
+    float endSpinVar{0.F};
+    float aspectRatio{1.F};
+
+    // gravity mode
+    Vec2 gravity;
+    float speed{180.F};
+    float speedVar{50.F};
+    float tangentialAccel{80.F};
+    float tangentialAccelVar{0.F};
+    float radialAccel{0.F};
+    float radialAccelVar{0.F};
+    bool rotationIsDir{false};
+
+    // radius mode
+    float startRadius{0.F};
+    float startRadiusVar{0.F};
+    float endRadius{0.F};
+    float endRadiusVar{0.F};
+    float rotatePerS{0.F};
+    float rotatePerSVar{0.F};
+};
+
+// particle-simulator-2d.ts with the particles stored as one array per attribute. The update runs as branch free
+// loops over those arrays, which the compiler vectorizes. The vertex generation interleaves 4 vertices per
+// particle and tracks the bounds, it stays scalar, and writes the quads straight into the vertex data handed to
+// the draw info. Emitters don't share any state, ParticleManager2D steps them in parallel.
+class ParticleSimulator2D final {
+public:
+    // quads indexed with 16 bits
+    static constexpr uint32_t MAX_PARTICLES = 16384;
+    static constexpr uint32_t VERTEX_STRIDE = 9;
+
+    using FinishedCallback = std::function<void()>;
+
+    ParticleSimulator2D();
+    ~ParticleSimulator2D();
+
+    // Applies to the next step, the live particles keep their values. A larger totalParticles grows the vertex
+    // data, the draw info is filled again with it.
+    void setConfig(const ParticleEmitterConfig2D& config);
+    inline const ParticleEmitterConfig2D& getConfig() const { return _config; }
+    // where the particles are emitted from
+    inline void setNode(Node* node) { _node = node; }
+    // u, v of the bottom left, bottom right, top left and top right corners, as SpriteFrame.uv
+    void setUVs(const float* uvs);
+    // filled with the quads after each step
+    inline void setDrawInfo(RenderDrawInfo* drawInfo) { _drawInfo = drawInfo; }
+    // called once no particle is left after stop() or the end of the duration
+    inline void setFinishedCallback(FinishedCallback callback) { _finishedCallback = std::move(callback); }
+    // seeds the random generator of the emitter, for reproducible effects
+    inline void setSeed(uint32_t seed) { _random = seed != 0 ? seed : 1; }
+
+    // shown in the stats of ParticleManager2D
+    inline void setName(const ccstd::string& name) { _name = name; }
+    inline const ccstd::string& getName() const { return _name; }
+    // emitters of higher priority keep their emission when the particle budget of ParticleManager2D runs out
+    inline void setPriority(int32_t priority) { _priority = priority; }
+    inline int32_t getPriority() const { return _priority; }
+    inline void setCulling(ParticleCulling2D culling) { _culling = culling; }
+    inline ParticleCulling2D getCulling() const { return _culling; }
+    // simulates the time paused when visible again, up to the longest particle life
+    inline void setCatchUp(bool catchUp) { _catchUp = catchUp; }
+    inline bool isCatchUp() const { return _catchUp; }
+    // of the node and color, the emitter counts as culled at 0
+    inline void setOpacity(float opacity) { _opacity = opacity; }
+    inline float getOpacity() const { return _opacity; }
+
+    void reset();
+    void stop();
+    inline bool isActive() const { return _active; }
+    inline bool isFinished() const { return _finished; }
+    inline uint32_t getParticleCount() const { return _count; }
+    // scale of the emission rate and total particles, from the budget of ParticleManager2D
+    inline float getEmissionScale() const { return _emissionScale; }
+    inline bool isCulled() const { return _culled; }
+    // microseconds spent simulating in the last frame stepped
+    inline float getStepCost() const { return _stepCost; }
+
+    void step(float dt);
+
+    // the quads of the live particles, x, y, z, u, v, r, g, b, a per vertex
+    inline const float* getVData() const { return _vData.data(); }
+    inline const uint16_t* getIData() const { return _iData.data(); }
+    void fillDrawInfo(RenderDrawInfo* drawInfo) const;
+
+private:
+    CC_DISALLOW_COPY_MOVE_ASSIGN(ParticleSimulator2D);
+    friend class ParticleManager2D;
+
+    enum Stream : uint32_t {
+        POS_X,
+        POS_Y,
+        START_POS_X,
+        START_POS_Y,
+        COLOR_R,
+        COLOR_G,
+        COLOR_B,
+        COLOR_A,
+        DELTA_COLOR_R,
+        DELTA_COLOR_G,
+        DELTA_COLOR_B,
+        DELTA_COLOR_A,
+        SIZE,
+        DELTA_SIZE,
+        ROTATION,
+        DELTA_ROTATION,
+        TIME_TO_LIVE,
+        ASPECT_RATIO,
+        // gravity mode: direction, radial and tangential acceleration
+        // radius mode: angle, degrees per second, radius and delta radius
+        MODE_0,
+        MODE_1,
+        MODE_2,
+        MODE_3,
+        STREAM_COUNT,
+    };
+
+    inline float* stream(Stream s) { return _streams.data() + static_cast<size_t>(s) * _capacity; }
+
+    // reads the node, on the calling thread
+    void beginStep();
+    float clampDeltaTime(float dt) const;
+    // Only touches the emitter, safe on any thread. The time skipped by throttling or pausing is simulated first, in
+    // substeps, then dt in one step as an emitter stepped every frame.
+    void simulate(float dt, float skippedTime);
+    void simulateStep(float dt);
+    // the longest time worth catching up on, older particles would be dead
+    float getMaxLife() const;
+    // whether the particles or the area they are emitted from may overlap the world rect
+    bool intersects(float left, float bottom, float right, float top) const;
+    // hands the quads over, on the calling thread
+    void endStep();
+
+    void reserve(uint32_t capacity);
+    void emit(float dt);
+    void emitParticle();
+    void integrate(float dt);
+    void removeDead();
+    void fillVertices();
+    float random();
+    // in [-1, 1)
+    inline float randomMinus1To1() { return (random() - 0.5F) * 2.F; }
+
+    ParticleEmitterConfig2D _config;
+    Node* _node{nullptr};
+    RenderDrawInfo* _drawInfo{nullptr};
+    FinishedCallback _finishedCallback;
+
+    // STREAM_COUNT arrays of _capacity floats
+    ccstd::vector<float> _streams;
+    uint32_t _capacity{0};
+    uint32_t _count{0};
+    // cos and sin of the rotation of each quad
+    ccstd::vector<float> _rotationScratch;
+
+    ccstd::vector<float> _vData;
+    ccstd::vector<uint16_t> _iData;
+    float _uvs[8]{0.F, 0.F, 1.F, 0.F, 0.F, 1.F, 1.F, 1.F};
+
+    // of the quads, in the space of the vertices
+    float _boundsMinX{0.F};
+    float _boundsMinY{0.F};
+    float _boundsMaxX{0.F};
+    float _boundsMaxY{0.F};
+
+    float _emitterX{0.F};
+    float _emitterY{0.F};
+    float _worldRotation{0.F};
+    float _elapsed{0.F};
+    float _emitCounter{0.F};
+    uint32_t _random{0x9E3779B9};
+
+    ccstd::string _name;
+    int32_t _priority{0};
+    ParticleCulling2D _culling{ParticleCulling2D::NONE};
+    float _opacity{1.F};
+    float _emissionScale{1.F};
+    // skipped by throttling or pausing, simulated with the next step
+    float _pendingTime{0.F};
+    // to simulate in this frame, the frame and what was pending before it
+    float _stepTime{0.F};
+    float _skippedTime{0.F};
+    float _stepCost{0.F};
+    uint32_t _throttleFrame{0};
+    bool _catchUp{false};
+    bool _culled{false};
+    bool _active{false};
+    bool _readyToPlay{true};
+    bool _finished{false};
+    bool _finishPending{false};
+    bool _registered{false};
+};
+
+} // namespace cc
@@ -31,10 +31,6 @@
 namespace cc {
 
 static gfx::DescriptorSetInfo gDsInfo;
-static float matrixData[pipeline::UBOLocal::COUNT] = {0.F};
-void mat4ToFloatArray(const cc::Mat4& mat, float* out, index_t ofs = 0) {
-    memcpy(out + ofs, mat.m, 16 * sizeof(float));
-}
 
 RenderDrawInfo::RenderDrawInfo() {
     _drawInfoAttrs._isMeshBuffer = 0;
@@ -61,10 +57,10 @@ void RenderDrawInfo::uploadBuffers() {
     CC_ASSERT(_drawInfoAttrs._isMeshBuffer && _drawInfoAttrs._drawInfoType == RenderDrawInfoType::COMP);
     if (_drawInfoAttrs._vbCount == 0 || _drawInfoAttrs._ibCount == 0) return;
     uint32_t size = _drawInfoAttrs._vbCount * 9 * sizeof(float); // magic Number
-    gfx::Buffer* vBuffer = _ia->getVertexBuffers()[0];
+    gfx::Buffer* vBuffer = _coldData->ia->getVertexBuffers()[0];
     vBuffer->resize(size);
     vBuffer->update(_vDataBuffer);
-    gfx::Buffer* iBuffer = _ia->getIndexBuffer();
+    gfx::Buffer* iBuffer = _coldData->ia->getIndexBuffer();
     uint32_t iSize = _drawInfoAttrs._ibCount * 2;
     iBuffer->resize(iSize);
     iBuffer->update(_iDataBuffer);
@@ -75,28 +71,43 @@ void RenderDrawInfo::resetMeshIA() { // NOLINT(readability-make-member-function-
 }
 
 void RenderDrawInfo::destroy() {
-    _vb = nullptr;
-    _ib = nullptr;
-    _ia = nullptr;
+    auto* batcher = Batcher2d::getAliveInstance();
+    // the address may be handed out again, an effect keyed by it mustn't write into the next owner
+    if (batcher != nullptr) {
+        batcher->removeMotionStreak(this);
+        batcher->removeParticleEmitter(this);
+    }
+    CC_SAFE_DELETE(_coldData);
     if (_localDSBF) {
+        if (batcher != nullptr) {
+            batcher->releaseLocalUBO(_localDSBF);
+        }
         CC_SAFE_DELETE(_localDSBF->ds);
         CC_SAFE_DELETE(_localDSBF->uboBuf);
         CC_SAFE_DELETE(_localDSBF);
     }
 }
 
+RenderDrawInfoColdData* RenderDrawInfo::requireColdData() {
+    if (_coldData == nullptr) {
+        _coldData = ccnew RenderDrawInfoColdData();
+    }
+    return _coldData;
+}
+
 gfx::InputAssembler* RenderDrawInfo::initIAInfo(gfx::Device* device) {
-    if (!_ia) {
+    auto* coldData = requireColdData();
+    if (!coldData->ia) {
         gfx::InputAssemblerInfo iaInfo = {};
         uint32_t vbStride = 9 * sizeof(float); // magic Number
         uint32_t ibStride = sizeof(uint16_t);
-        _vb = device->createBuffer({
+        coldData->vb = device->createBuffer({
             gfx::BufferUsageBit::VERTEX | gfx::BufferUsageBit::TRANSFER_DST,
             gfx::MemoryUsageBit::DEVICE | gfx::MemoryUsageBit::HOST,
             vbStride * 3,
             vbStride,
         });
-        _ib = device->createBuffer({
+        coldData->ib = device->createBuffer({
             gfx::BufferUsageBit::INDEX | gfx::BufferUsageBit::TRANSFER_DST,
             gfx::MemoryUsageBit::DEVICE | gfx::MemoryUsageBit::HOST,
             ibStride * 3,
@@ -104,36 +115,38 @@ gfx::InputAssembler* RenderDrawInfo::initIAInfo(gfx::Device* device) {
         });
 
         iaInfo.attributes = *(Root::getInstance()->getBatcher2D()->getDefaultAttribute());
-        iaInfo.vertexBuffers.emplace_back(_vb);
-        iaInfo.indexBuffer = _ib;
+        iaInfo.vertexBuffers.emplace_back(coldData->vb);
+        iaInfo.indexBuffer = coldData->ib;
 
-        _ia = device->createInputAssembler(iaInfo);
+        coldData->ia = device->createInputAssembler(iaInfo);
     }
-    return _ia;
+    return coldData->ia;
 }
 
 void RenderDrawInfo::updateLocalDescriptorSet(Node* transform, const gfx::DescriptorSetLayout* dsLayout) {
+    auto* batcher = Root::getInstance()->getBatcher2D();
+    bool bindingChanged = false;
     if (_localDSBF == nullptr) {
         _localDSBF = new LocalDSBF();
         auto* device = Root::getInstance()->getDevice();
         gDsInfo.layout = dsLayout;
         _localDSBF->ds = device->createDescriptorSet(gDsInfo);
-        _localDSBF->uboBuf = device->createBuffer({
-            gfx::BufferUsageBit::UNIFORM | gfx::BufferUsageBit::TRANSFER_DST,
-            gfx::MemoryUsageBit::HOST | gfx::MemoryUsageBit::DEVICE,
-            pipeline::UBOLocal::SIZE,
-            pipeline::UBOLocal::SIZE,
-        });
+        batcher->allocateLocalUBO(_localDSBF);
+        _localDSBF->ds->bindBuffer(pipeline::UBOLocal::BINDING, _localDSBF->uboBuf);
+        bindingChanged = true;
     }
-    if (_texture != nullptr && _sampler != nullptr) {
+    if (_texture != nullptr && _sampler != nullptr && (_localDSBF->texture != _texture || _localDSBF->sampler != _sampler)) {
+        _localDSBF->texture = _texture;
+        _localDSBF->sampler = _sampler;
         _localDSBF->ds->bindTexture(static_cast<uint32_t>(pipeline::ModelLocalBindings::SAMPLER_SPRITE), _texture);
         _localDSBF->ds->bindSampler(static_cast<uint32_t>(pipeline::ModelLocalBindings::SAMPLER_SPRITE), _sampler);
+        bindingChanged = true;
+    }
+    // the UBO content is uploaded with its page, the descriptor set only changes with its bindings
+    if (bindingChanged) {
+        _localDSBF->ds->update();
     }
-    _localDSBF->ds->bindBuffer(pipeline::UBOLocal::BINDING, _localDSBF->uboBuf);
-    _localDSBF->ds->update();
-    const auto& worldMatrix = transform->getWorldMatrix();
-    mat4ToFloatArray(worldMatrix, matrixData, pipeline::UBOLocal::MAT_WORLD_OFFSET);
-    _localDSBF->uboBuf->update(matrixData);
+    batcher->updateLocalUBO(_localDSBF, transform->getWorldMatrix());
 }
 
 } // namespace cc
@@ -53,8 +53,28 @@ enum class RenderDrawInfoType : uint8_t {
 };
 
 struct LocalDSBF {
-    gfx::DescriptorSet* ds;
-    gfx::Buffer* uboBuf;
+    gfx::DescriptorSet* ds{nullptr};
+    // view into a shared local UBO page of Batcher2d
+    gfx::Buffer* uboBuf{nullptr};
+    uint32_t page{0};
+    uint32_t slot{0};
+    // weak reference, bound to ds
+    gfx::Texture* texture{nullptr};
+    // weak reference, bound to ds
+    gfx::Sampler* sampler{nullptr};
+};
+
+// Data which the batcher doesn't read for every draw, allocated on demand.
+struct RenderDrawInfoColdData {
+    // ia
+    IntrusivePtr<gfx::InputAssembler> ia;
+    IntrusivePtr<gfx::Buffer> vb;
+    IntrusivePtr<gfx::Buffer> ib;
+
+    // set while the vertex buffer holds rect clipped positions and uvs
+    bool vertexClipped{false};
+    // per vertex: u, v before the clip, u, v written by the clip
+    ccstd::vector<float> clipUVs;
 };
 
 class Batcher2d;
@@ -120,6 +140,14 @@ public:
         return _drawInfoAttrs._isVertexPositionInWorld != 0;
     }
 
+    // Native only, kept in the cold data as JS writes the attrs as a whole.
+    inline bool isVertexClipped() const {
+        return _coldData != nullptr && _coldData->vertexClipped;
+    }
+    inline void setVertexClipped(bool clipped) {
+        requireColdData()->vertexClipped = clipped;
+    }
+
     inline uint8_t getStride() const { return _drawInfoAttrs._stride; }
     inline void setStride(uint8_t stride) {
         _drawInfoAttrs._stride = stride;
@@ -220,6 +248,9 @@ public:
 
     inline se::Object* getAttrSharedBufferForJS() const { return _attrSharedBufferActor.getSharedArrayBufferObject(); }
 
+    inline RenderDrawInfoColdData* getColdData() const { return _coldData; }
+    RenderDrawInfoColdData* requireColdData();
+
     gfx::InputAssembler* requestIA(gfx::Device* device);
     void uploadBuffers();
     void resetMeshIA();
@@ -276,38 +307,36 @@ private:
     } _drawInfoAttrs{};
 
     bindings::NativeMemorySharedToScriptActor _attrSharedBufferActor;
+    // read by Batcher2d for every draw
     // weak reference
     Material* _material{nullptr};
     // weak reference
-    float* _vDataBuffer{nullptr};
-    // weak reference
-    uint16_t* _iDataBuffer{nullptr};
+    gfx::Texture* _texture{nullptr};
     // weak reference
     UIMeshBuffer* _meshBuffer{nullptr};
+    union {
+        Node* _subNode{nullptr};
+        scene::Model* _model;
+        uint8_t* _sharedBuffer;
+    };
+
+    // read for component draws only, the index fill reads the data buffers of every draw info
     // weak reference
-    gfx::Texture* _texture{nullptr};
+    float* _vDataBuffer{nullptr};
     // weak reference
-    gfx::Sampler* _sampler{nullptr};
+    uint16_t* _iDataBuffer{nullptr};
     // weak reference
     float* _vbBuffer{nullptr};
     // weak reference
     uint16_t* _ibBuffer{nullptr};
-
-    union {
-        Node* _subNode{nullptr};
-        scene::Model* _model;
-        uint8_t* _sharedBuffer;
-    };
+    // weak reference
+    gfx::Sampler* _sampler{nullptr};
     LocalDSBF* _localDSBF{nullptr};
-
-    // ia
-    IntrusivePtr<gfx::InputAssembler> _ia;
-    IntrusivePtr<gfx::Buffer> _vb;
-    IntrusivePtr<gfx::Buffer> _ib;
+    RenderDrawInfoColdData* _coldData{nullptr};
 };
 
 #if defined(__x86_64__) || defined(__amd64__) || defined(__aarch64__)
-static_assert(sizeof(RenderDrawInfo) == 144, "Be carefull to add property to RenderDrawInfo which may cause the potential cache miss");
+static_assert(sizeof(RenderDrawInfo) == 128, "Be carefull to add property to RenderDrawInfo which may cause the potential cache miss");
 #endif
 
 } // namespace cc
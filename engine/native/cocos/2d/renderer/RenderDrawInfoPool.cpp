@@ -0,0 +1,177 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#include "2d/renderer/RenderDrawInfoPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include "2d/renderer/RenderEntity.h"
+#include "base/Log.h"
+
+namespace cc {
+namespace {
+RenderDrawInfoPool* instance = nullptr;
+
+void* allocChunk() {
+#if CC_PLATFORM == CC_PLATFORM_WINDOWS
+    return _aligned_malloc(RenderDrawInfoPool::CHUNK_BYTES, RenderDrawInfoPool::CHUNK_BYTES);
+#else
+    void* chunk = nullptr;
+    return posix_memalign(&chunk, RenderDrawInfoPool::CHUNK_BYTES, RenderDrawInfoPool::CHUNK_BYTES) == 0 ? chunk : nullptr;
+#endif
+}
+
+void freeChunk(void* chunk) {
+#if CC_PLATFORM == CC_PLATFORM_WINDOWS
+    _aligned_free(chunk);
+#else
+    std::free(chunk);
+#endif
+}
+} // namespace
+
+RenderDrawInfoPool* RenderDrawInfoPool::getInstance() {
+    if (instance == nullptr) {
+        instance = new RenderDrawInfoPool();
+    }
+    return instance;
+}
+
+void RenderDrawInfoPool::destroyInstance() {
+    delete instance;
+    instance = nullptr;
+}
+
+RenderDrawInfoPool::~RenderDrawInfoPool() {
+    // the entities of draw infos still in use skip them once the pool is gone
+    for (uint32_t index = 0; index < _generations.size(); index++) {
+        if ((_generations[index] & 1) != 0) {
+            getSlot(_chunks[index / CHUNK_SIZE], index % CHUNK_SIZE)->~RenderDrawInfo();
+        }
+    }
+    for (auto chunkBase : _chunks) {
+        freeChunk(reinterpret_cast<void*>(chunkBase));
+    }
+    _chunks.clear();
+    _chunkSet.clear();
+    _generations.clear();
+    _freeList.clear();
+    _releasedSlots.clear();
+}
+
+void RenderDrawInfoPool::addChunk() {
+    void* chunk = allocChunk();
+    CC_ASSERT(chunk != nullptr);
+    const auto chunkBase = reinterpret_cast<uintptr_t>(chunk);
+    auto* header = reinterpret_cast<ChunkHeader*>(chunkBase);
+    header->chunkIndex = static_cast<uint32_t>(_chunks.size());
+    _chunks.push_back(chunkBase);
+    _chunkSet.insert(chunkBase);
+
+    const uint32_t first = header->chunkIndex * CHUNK_SIZE;
+    _generations.resize(first + CHUNK_SIZE, 0);
+    // in reverse, so the chunk is handed out in address order
+    for (uint32_t i = CHUNK_SIZE; i > 0; i--) {
+        _freeList.push_back(first + i - 1);
+    }
+}
+
+RenderDrawInfo* RenderDrawInfoPool::alloc() {
+    if (_freeList.empty()) {
+        addChunk();
+    }
+
+    const uint32_t index = _freeList.back();
+    _freeList.pop_back();
+    ++_generations[index];
+    ++_usedCount;
+    _highWaterMark = std::max(_highWaterMark, _usedCount);
+    return ccnew_placement(getSlot(_chunks[index / CHUNK_SIZE], index % CHUNK_SIZE)) RenderDrawInfo();
+}
+
+void RenderDrawInfoPool::free(RenderDrawInfo* drawInfo) {
+    if (drawInfo == nullptr) {
+        return;
+    }
+    const uint32_t index = getIndex(drawInfo);
+    CC_ASSERT((_generations[index] & 1) != 0); // double free
+    drawInfo->~RenderDrawInfo();
+    ++_generations[index];
+    _releasedSlots.push_back({index, _frame});
+    --_usedCount;
+}
+
+void RenderDrawInfoPool::freeAll(RenderDrawInfo* const* drawInfos, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (drawInfos[i] != nullptr && isPooled(drawInfos[i])) {
+            free(drawInfos[i]);
+        }
+    }
+}
+
+void RenderDrawInfoPool::endFrame() {
+    ++_frame;
+    size_t count = 0;
+    while (count < _releasedSlots.size() && _frame - _releasedSlots[count].frame >= REUSE_DELAY_FRAMES) {
+        _freeList.push_back(_releasedSlots[count].index);
+        ++count;
+    }
+    _releasedSlots.erase(_releasedSlots.begin(), _releasedSlots.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+bool RenderDrawInfoPool::isPooled(const RenderDrawInfo* drawInfo) const {
+    return _chunkSet.find(getChunkBase(drawInfo)) != _chunkSet.end();
+}
+
+uint32_t RenderDrawInfoPool::getIndex(const RenderDrawInfo* drawInfo) const {
+    const uintptr_t chunkBase = getChunkBase(drawInfo);
+    const auto* header = reinterpret_cast<const ChunkHeader*>(chunkBase);
+    const auto slot = static_cast<uint32_t>(drawInfo - getSlot(chunkBase, 0));
+    return header->chunkIndex * CHUNK_SIZE + slot;
+}
+
+void RenderDrawInfoPool::printMemoryReport() const {
+    const uint32_t entityCount = RenderEntity::getInstanceCount();
+    const size_t entityBytes = entityCount * sizeof(RenderEntity);
+    // the chunks and the bookkeeping of the slots
+    const size_t poolBytes = _chunks.size() * CHUNK_BYTES +
+                             _chunks.capacity() * sizeof(uintptr_t) +
+                             _chunkSet.size() * (sizeof(uintptr_t) + 2 * sizeof(void*)) + _chunkSet.bucket_count() * sizeof(void*) +
+                             _generations.capacity() * sizeof(uint32_t) +
+                             _freeList.capacity() * sizeof(uint32_t) +
+                             _releasedSlots.capacity() * sizeof(ReleasedSlot);
+    // entity with the static draw infos inline instead of the pointers
+    const size_t inlineEntitySize = sizeof(RenderEntity) - RenderEntity::STATIC_DRAW_INFO_CAPACITY * sizeof(RenderDrawInfo*) + RenderEntity::STATIC_DRAW_INFO_CAPACITY * sizeof(RenderDrawInfo);
+    const size_t inlineBytes = entityCount * inlineEntitySize;
+
+    CC_LOG_INFO("RenderEntity memory: %u entities * %u bytes = %u bytes, pool %u chunks = %u bytes",
+                entityCount, static_cast<uint32_t>(sizeof(RenderEntity)), static_cast<uint32_t>(entityBytes),
+                static_cast<uint32_t>(_chunks.size()), static_cast<uint32_t>(poolBytes));
+    CC_LOG_INFO("RenderEntity memory: draw infos used %u, waiting for reuse %u, high water mark %u, capacity %u * %u bytes",
+                _usedCount, static_cast<uint32_t>(_releasedSlots.size()), _highWaterMark, getCapacity(), static_cast<uint32_t>(sizeof(RenderDrawInfo)));
+    CC_LOG_INFO("RenderEntity memory: total %u bytes, inline layout %u entities * %u bytes = %u bytes",
+                static_cast<uint32_t>(entityBytes + poolBytes), entityCount, static_cast<uint32_t>(inlineEntitySize), static_cast<uint32_t>(inlineBytes));
+}
+
+} // namespace cc
@@ -0,0 +1,107 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+
+#pragma once
+
+#include "2d/renderer/RenderDrawInfo.h"
+#include "base/Macros.h"
+#include "base/TypeDef.h"
+#include "base/std/container/unordered_set.h"
+#include "base/std/container/vector.h"
+
+namespace cc {
+
+// Slab storage of native owned draw infos. Draw infos are constructed in place in chunks aligned to their
+// size, so the slot of a draw info is found from its address and its address stays valid for JS until it is
+// released. Alloc and free are O(1).
+// A released slot is only handed out again after REUSE_DELAY_FRAMES calls of endFrame(), JS objects and the
+// batches of the frame in flight may still point at it meanwhile.
+class RenderDrawInfoPool final {
+public:
+    static constexpr uint32_t CHUNK_BYTES = 64 * 1024;
+    static constexpr uint32_t REUSE_DELAY_FRAMES = 2;
+    static constexpr uint32_t CHUNK_HEADER_BYTES = 16;
+    static constexpr uint32_t CHUNK_SIZE = (CHUNK_BYTES - CHUNK_HEADER_BYTES) / sizeof(RenderDrawInfo);
+
+    static RenderDrawInfoPool* getInstance();
+    // Called by ~Batcher2d, the draw infos still in use release their GPU resources before the device.
+    static void destroyInstance();
+    RenderDrawInfoPool() = default;
+    ~RenderDrawInfoPool();
+
+    RenderDrawInfo* alloc();
+    void free(RenderDrawInfo* drawInfo);
+    // Releases the draw infos of an entity at once, the ones not allocated from the pool are skipped.
+    void freeAll(RenderDrawInfo* const* drawInfos, uint32_t count);
+    // Called by Batcher2d once per frame, returns the slots released long enough ago to the free list.
+    void endFrame();
+
+    // If the draw info is allocated from the pool, e.g. not created from JS.
+    bool isPooled(const RenderDrawInfo* drawInfo) const;
+
+    inline uint32_t getUsedCount() const { return _usedCount; }
+    inline uint32_t getHighWaterMark() const { return _highWaterMark; }
+    inline uint32_t getCapacity() const { return static_cast<uint32_t>(_chunks.size()) * CHUNK_SIZE; }
+
+    // Logs the footprint of the render entities and the pool, compared with the former inline layout.
+    void printMemoryReport() const;
+
+private:
+    CC_DISALLOW_COPY_MOVE_ASSIGN(RenderDrawInfoPool);
+
+    struct ChunkHeader {
+        uint32_t chunkIndex{0};
+    };
+
+    struct ReleasedSlot {
+        uint32_t index{0};
+        // endFrame() count when the slot was released
+        uint32_t frame{0};
+    };
+    static_assert(sizeof(ChunkHeader) <= CHUNK_HEADER_BYTES, "ChunkHeader doesn't fit in the chunk header");
+
+    static inline uintptr_t getChunkBase(const RenderDrawInfo* drawInfo) {
+        return reinterpret_cast<uintptr_t>(drawInfo) & ~static_cast<uintptr_t>(CHUNK_BYTES - 1);
+    }
+    static inline RenderDrawInfo* getSlot(uintptr_t chunkBase, uint32_t slot) {
+        return reinterpret_cast<RenderDrawInfo*>(chunkBase + CHUNK_HEADER_BYTES) + slot;
+    }
+    uint32_t getIndex(const RenderDrawInfo* drawInfo) const;
+    void addChunk();
+
+    // manage memory manually, aligned to CHUNK_BYTES
+    ccstd::vector<uintptr_t> _chunks;
+    ccstd::unordered_set<uintptr_t> _chunkSet;
+    // odd while the slot is in use
+    ccstd::vector<uint32_t> _generations;
+    ccstd::vector<uint32_t> _freeList;
+    // in release order
+    ccstd::vector<ReleasedSlot> _releasedSlots;
+    uint32_t _frame{0};
+    uint32_t _usedCount{0};
+    uint32_t _highWaterMark{0};
+};
+
+} // namespace cc
@@ -24,12 +24,23 @@
 
 #include "2d/renderer/RenderEntity.h"
 #include "2d/renderer/Batcher2d.h"
+#include "2d/renderer/RenderDrawInfoPool.h"
 #include "bindings/utils/BindingUtils.h"
 
 namespace cc {
+namespace {
+uint32_t instanceCount = 0;
+}
+
+uint32_t RenderEntity::getInstanceCount() {
+    return instanceCount;
+}
+
 RenderEntity::RenderEntity(RenderEntityType type) : _renderEntityType(type) {
+    ++instanceCount;
     if (type == RenderEntityType::STATIC) {
-        ccnew_placement(&_staticDrawInfos) std::array<RenderDrawInfo, RenderEntity::STATIC_DRAW_INFO_CAPACITY>();
+        ccnew_placement(&_staticDrawInfos) std::array<RenderDrawInfo*, RenderEntity::STATIC_DRAW_INFO_CAPACITY>();
+        _staticDrawInfos.fill(nullptr);
     } else {
         ccnew_placement(&_dynamicDrawInfos) ccstd::vector<RenderDrawInfo*>();
     }
@@ -42,9 +53,12 @@ RenderEntity::RenderEntity(RenderEntityType type) : _renderEntityType(type) {
 }
 
 RenderEntity::~RenderEntity() {
+    --instanceCount;
     if (_renderEntityType == RenderEntityType::STATIC) {
+        RenderDrawInfoPool::getInstance()->freeAll(_staticDrawInfos.data(), RenderEntity::STATIC_DRAW_INFO_CAPACITY);
         _staticDrawInfos.~array();
     } else {
+        RenderDrawInfoPool::getInstance()->freeAll(_dynamicDrawInfos.data(), static_cast<uint32_t>(_dynamicDrawInfos.size()));
         _dynamicDrawInfos.~vector();
     }
 };
@@ -56,17 +70,23 @@ void RenderEntity::addDynamicRenderDrawInfo(RenderDrawInfo* drawInfo) {
 void RenderEntity::setDynamicRenderDrawInfo(RenderDrawInfo* drawInfo, uint32_t index) {
     CC_ASSERT_NE(_renderEntityType, RenderEntityType::STATIC);
     if (index < _dynamicDrawInfos.size()) {
+        if (_dynamicDrawInfos[index] != drawInfo) {
+            RenderDrawInfoPool::getInstance()->freeAll(&_dynamicDrawInfos[index], 1);
+        }
         _dynamicDrawInfos[index] = drawInfo;
     }
 }
 void RenderEntity::removeDynamicRenderDrawInfo() {
     CC_ASSERT_NE(_renderEntityType, RenderEntityType::STATIC);
     if (_dynamicDrawInfos.empty()) return;
-    _dynamicDrawInfos.pop_back(); // warning: memory leaking & crash
+    // draw infos created from JS are released by JS
+    RenderDrawInfoPool::getInstance()->freeAll(&_dynamicDrawInfos.back(), 1);
+    _dynamicDrawInfos.pop_back();
 }
 
 void RenderEntity::clearDynamicRenderDrawInfos() {
     CC_ASSERT_NE(_renderEntityType, RenderEntityType::STATIC);
+    RenderDrawInfoPool::getInstance()->freeAll(_dynamicDrawInfos.data(), static_cast<uint32_t>(_dynamicDrawInfos.size()));
     _dynamicDrawInfos.clear();
 }
 
@@ -74,8 +94,7 @@ void RenderEntity::clearStaticRenderDrawInfos() {
     CC_ASSERT_EQ(_renderEntityType, RenderEntityType::STATIC);
 
     for (uint32_t i = 0; i < _staticDrawInfoSize; i++) {
-        RenderDrawInfo& drawInfo = _staticDrawInfos[i];
-        drawInfo.resetDrawInfo();
+        _staticDrawInfos[i]->resetDrawInfo();
     }
     _staticDrawInfoSize = 0;
 }
@@ -90,6 +109,37 @@ void RenderEntity::setNode(Node* node) {
     }
 }
 
+void RenderEntity::setGeometricClipRect(float x, float y, float width, float height) {
+    _maskRect.left = x;
+    _maskRect.bottom = y;
+    _maskRect.right = x + width;
+    _maskRect.top = y + height;
+    _useGeometricClip = true;
+    _analyticMaskShape = AnalyticMaskShape::NONE;
+    _stencilFreeMaskState = StencilFreeMaskState::UNCHECKED;
+}
+
+void RenderEntity::clearGeometricClip() {
+    _useGeometricClip = false;
+    _stencilFreeMaskState = StencilFreeMaskState::UNCHECKED;
+}
+
+void RenderEntity::setAnalyticMask(uint32_t shape, float x, float y, float width, float height, float cornerRadius) { // NOLINT(bugprone-easily-swappable-parameters)
+    _maskRect.left = x;
+    _maskRect.bottom = y;
+    _maskRect.right = x + width;
+    _maskRect.top = y + height;
+    _maskCornerRadius = cornerRadius;
+    _analyticMaskShape = static_cast<AnalyticMaskShape>(shape);
+    _useGeometricClip = false;
+    _stencilFreeMaskState = StencilFreeMaskState::UNCHECKED;
+}
+
+void RenderEntity::clearAnalyticMask() {
+    _analyticMaskShape = AnalyticMaskShape::NONE;
+    _stencilFreeMaskState = StencilFreeMaskState::UNCHECKED;
+}
+
 void RenderEntity::setRenderTransform(Node* renderTransform) {
     _renderTransform = renderTransform;
 }
@@ -107,13 +157,18 @@ ccstd::vector<RenderDrawInfo*>& RenderEntity::getDynamicRenderDrawInfos() {
 }
 void RenderEntity::setStaticDrawInfoSize(uint32_t size) {
     CC_ASSERT(_renderEntityType == RenderEntityType::STATIC && size <= RenderEntity::STATIC_DRAW_INFO_CAPACITY);
+    for (uint32_t i = 0; i < size; i++) {
+        if (_staticDrawInfos[i] == nullptr) {
+            _staticDrawInfos[i] = RenderDrawInfoPool::getInstance()->alloc();
+        }
+    }
     _staticDrawInfoSize = size;
 }
 RenderDrawInfo* RenderEntity::getStaticRenderDrawInfo(uint32_t index) {
     CC_ASSERT(_renderEntityType == RenderEntityType::STATIC && index < _staticDrawInfoSize);
-    return &(_staticDrawInfos[index]);
+    return _staticDrawInfos[index];
 }
-std::array<RenderDrawInfo, RenderEntity::STATIC_DRAW_INFO_CAPACITY>& RenderEntity::getStaticRenderDrawInfos() {
+std::array<RenderDrawInfo*, RenderEntity::STATIC_DRAW_INFO_CAPACITY>& RenderEntity::getStaticRenderDrawInfos() {
     CC_ASSERT_EQ(_renderEntityType, RenderEntityType::STATIC);
     return _staticDrawInfos;
 }
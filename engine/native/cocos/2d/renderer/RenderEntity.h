@@ -68,6 +68,27 @@ struct EntityAttrLayout {
     uint8_t paddings2{0};
 };
 
+enum class AnalyticMaskShape : uint8_t {
+    NONE,
+    ELLIPSE,
+    ROUNDED_RECT,
+};
+
+// Whether the content below a mask can be clipped without stencil, see Batcher2d::enterStencilFreeMask.
+enum class StencilFreeMaskState : uint8_t {
+    UNCHECKED,
+    SUPPORTED,
+    UNSUPPORTED,
+};
+
+// Axis aligned rectangle, in the local space of the mask node when stored on an entity.
+struct ClipRect {
+    float left{0.F};
+    float bottom{0.F};
+    float right{0.F};
+    float top{0.F};
+};
+
 static_assert(sizeof(EntityAttrLayout) == 12, "Be carefull to add property to EntityAttrLayout which may cause the potential cache miss");
 
 class RenderEntity final : public Node::UserData {
@@ -100,6 +121,25 @@ public:
         _entityAttrLayout.useLocal = useLocal;
     }
     
+    // Rect masks with a geometric clip rect don't write stencil, their children are clipped on the CPU instead.
+    // Batcher2d falls back to stencil if the mask is rotated or the content can't be clipped.
+    inline bool getUseGeometricClip() const { return _useGeometricClip; }
+    inline const ClipRect& getGeometricClipRect() const { return _maskRect; }
+    void setGeometricClipRect(float x, float y, float width, float height);
+    void clearGeometricClip();
+
+    // Ellipse and rounded rect masks evaluated in the fragment shader of the children, see Batcher2d::getAnalyticMaskMaterial.
+    // Batcher2d falls back to stencil if the mask is rotated or a child material doesn't support it.
+    inline AnalyticMaskShape getAnalyticMaskShape() const { return _analyticMaskShape; }
+    inline const ClipRect& getAnalyticMaskRect() const { return _maskRect; }
+    inline float getAnalyticMaskCornerRadius() const { return _maskCornerRadius; }
+    void setAnalyticMask(uint32_t shape, float x, float y, float width, float height, float cornerRadius);
+    void clearAnalyticMask();
+
+    // Checked by Batcher2d while it walks the content of the mask, used from the next frame on.
+    inline StencilFreeMaskState getStencilFreeMaskState() const { return _stencilFreeMaskState; }
+    inline void setStencilFreeMaskState(StencilFreeMaskState state) { _stencilFreeMaskState = state; }
+
     inline FillColorType getFillColorType() const { return _entityAttrLayout.fillColorType; }
 
     inline Node* getNode() const { return _node; }
@@ -123,7 +163,7 @@ public:
     void setStaticDrawInfoSize(uint32_t size);
 
     RenderDrawInfo* getStaticRenderDrawInfo(uint32_t index);
-    std::array<RenderDrawInfo, RenderEntity::STATIC_DRAW_INFO_CAPACITY>& getStaticRenderDrawInfos();
+    std::array<RenderDrawInfo*, RenderEntity::STATIC_DRAW_INFO_CAPACITY>& getStaticRenderDrawInfos();
     RenderDrawInfo* getDynamicRenderDrawInfo(uint32_t index);
     ccstd::vector<RenderDrawInfo*>& getDynamicRenderDrawInfos();
 
@@ -140,8 +180,11 @@ public:
         return _renderEntityType == RenderEntityType::STATIC ? _staticDrawInfoSize : static_cast<uint32_t>(_dynamicDrawInfos.size());
     }
     inline RenderDrawInfo* getRenderDrawInfoAt(uint32_t index) {
-        return _renderEntityType == RenderEntityType::STATIC ? &(_staticDrawInfos[index]) : _dynamicDrawInfos[index];
+        return _renderEntityType == RenderEntityType::STATIC ? _staticDrawInfos[index] : _dynamicDrawInfos[index];
     }
+
+    // Number of living render entities, see RenderDrawInfoPool::printMemoryReport.
+    static uint32_t getInstanceCount();
     
     inline uint32_t getPriority() const { return _entityAttrLayout.priority; }
 
@@ -156,7 +199,8 @@ private:
     bindings::NativeMemorySharedToScriptActor _entitySharedBufferActor;
 
     union {
-        std::array<RenderDrawInfo, RenderEntity::STATIC_DRAW_INFO_CAPACITY> _staticDrawInfos;
+        // allocated from RenderDrawInfoPool on demand, kept until the entity is destroyed as JS holds them
+        std::array<RenderDrawInfo*, RenderEntity::STATIC_DRAW_INFO_CAPACITY> _staticDrawInfos;
         ccstd::vector<RenderDrawInfo*> _dynamicDrawInfos;
     };
     EntityAttrLayout _entityAttrLayout;
@@ -165,13 +209,18 @@ private:
     RenderEntityType _renderEntityType{RenderEntityType::STATIC};
     uint8_t _staticDrawInfoSize{0};
     bool _vbColorDirty{true};
-    uint8_t _paddings[1];
-    
+    bool _useGeometricClip{false};
+    AnalyticMaskShape _analyticMaskShape{AnalyticMaskShape::NONE};
+    StencilFreeMaskState _stencilFreeMaskState{StencilFreeMaskState::UNCHECKED};
+
     float _opacity{1.0F};
+    // shared by the geometric clip and the analytic mask, a mask uses one of them at most
+    ClipRect _maskRect;
+    float _maskCornerRadius{0.F};
 };
 
 #if defined(__x86_64__) || defined(__amd64__) || defined(__aarch64__)
-static_assert(sizeof(RenderEntity) == 640, "Be carefull to add property to RenderEntity which may cause the potential cache miss");
+static_assert(sizeof(RenderEntity) == 120, "Be carefull to add property to RenderEntity which may cause the potential cache miss");
 #endif
 
 } // namespace cc
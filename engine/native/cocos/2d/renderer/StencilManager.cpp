@@ -47,43 +47,70 @@ StencilManager::~StencilManager() {
     }
 }
 
+void StencilManager::pushMask() {
+    if (_maskStackSize >= MAX_MASK_DEPTH) {
+        // Not supported, out of stencil bits. Keep the stack balanced and write the deepest bit again.
+        ++_maskStackSize;
+        _clearBits = getWriteMask();
+        return;
+    }
+
+    const uint32_t freeBits = ~_stencilRef & STENCIL_BITS;
+    const uint32_t cleanBits = freeBits & ~_dirtyBits;
+    uint32_t bit = 0;
+    if (cleanBits != 0) {
+        bit = cleanBits & (~cleanBits + 1);
+        _clearBits = 0;
+    } else {
+        bit = freeBits & (~freeBits + 1);
+        _clearBits = freeBits;
+    }
+    _maskBits[_maskStackSize++] = bit;
+    _stencilRef |= bit;
+}
+
 StencilStage StencilManager::clear(RenderEntity* entity) { // NOLINT(readability-convert-member-functions-to-static)
     bool inverted = entity->getIsMaskInverted();
+    if (inverted && _clearBits == 0) {
+        // only the bit of this level is filled
+        _clearBits = getWriteMask();
+    }
     return inverted ? StencilStage::CLEAR_INVERTED : StencilStage::CLEAR;
 }
 
 void StencilManager::enterLevel(RenderEntity* entity) { // NOLINT(readability-convert-member-functions-to-static)
     bool inverted = entity->getIsMaskInverted();
     entity->setEnumStencilStage(inverted ? StencilStage::ENTER_LEVEL_INVERTED : StencilStage::ENTER_LEVEL);
+    _dirtyBits = (_dirtyBits & ~_clearBits) | getWriteMask();
+    _clearBits = 0;
 }
 
 gfx::DepthStencilState* StencilManager::getDepthStencilState(StencilStage stage, Material* mat) {
-    uint32_t key = 0;
     bool depthTest = false;
     bool depthWrite = false;
     gfx::ComparisonFunc depthFunc = gfx::ComparisonFunc::LESS;
     auto* cacheMap = &_cacheStateMap;
 
+    setDepthStencilStateFromStage(stage);
+    uint64_t key = getStencilKey(_stencilPattern);
+
     if (mat && !mat->getPasses()->empty()) {
         IntrusivePtr<scene::Pass>& pass = mat->getPasses()->at(0);
         const gfx::DepthStencilState* dss = pass->getDepthStencilState();
-        uint32_t depthTestValue = 0;
-        uint32_t depthWriteValue = 0;
+        uint64_t depthTestValue = 0;
+        uint64_t depthWriteValue = 0;
         if (dss->depthTest) {
             depthTestValue = 1;
         }
         if (dss->depthWrite) {
             depthWriteValue = 1;
         }
-        key = (depthTestValue) | (depthWriteValue << 1) | (static_cast<uint32_t>(dss->depthFunc) << 2) | (static_cast<uint32_t>(stage) << 6) | (_maskStackSize << 9);
+        key |= (depthTestValue << 31) | (depthWriteValue << 32) | (static_cast<uint64_t>(dss->depthFunc) << 33);
 
         depthTest = dss->depthTest;
         depthWrite = static_cast<uint32_t>(dss->depthWrite);
         depthFunc = dss->depthFunc;
         cacheMap = &_cacheStateMapWithDepth;
-
-    } else {
-        key = ((static_cast<uint32_t>(stage)) << 16) | (_maskStackSize);
     }
 
     auto iter = cacheMap->find(key);
@@ -91,8 +118,6 @@ gfx::DepthStencilState* StencilManager::getDepthStencilState(StencilStage stage,
         return iter->second;
     }
 
-    setDepthStencilStateFromStage(stage);
-
     auto* depthStencilState = ccnew gfx::DepthStencilState();
     depthStencilState->depthTest = depthTest;
     depthStencilState->depthWrite = depthWrite;
@@ -114,15 +139,17 @@ gfx::DepthStencilState* StencilManager::getDepthStencilState(StencilStage stage,
     depthStencilState->stencilPassOpBack = _stencilPattern.passOp;
     depthStencilState->stencilRefBack = _stencilPattern.ref;
 
-    const auto& pair = std::pair<uint32_t, gfx::DepthStencilState*>(key, depthStencilState);
+    const auto& pair = std::pair<uint64_t, gfx::DepthStencilState*>(key, depthStencilState);
     cacheMap->insert(pair);
 
     return depthStencilState;
 }
 
 void StencilManager::setDepthStencilStateFromStage(StencilStage stage) {
-    StencilEntity& pattern = _stencilPattern;
+    fillStencilPattern(stage, _stencilPattern);
+}
 
+void StencilManager::fillStencilPattern(StencilStage stage, StencilEntity& pattern) const {
     if (stage == StencilStage::DISABLED) {
         pattern.stencilTest = false;
         pattern.func = gfx::ComparisonFunc::ALWAYS;
@@ -139,13 +166,15 @@ void StencilManager::setDepthStencilStateFromStage(StencilStage stage) {
         } else if (stage == StencilStage::CLEAR) {
             pattern.func = gfx::ComparisonFunc::NEVER;
             pattern.failOp = gfx::StencilOp::ZERO;
-            pattern.writeMask = getWriteMask();
-            pattern.stencilMask = getWriteMask();
+            pattern.writeMask = _clearBits;
+            pattern.stencilMask = _clearBits;
             pattern.ref = getWriteMask();
         } else if (stage == StencilStage::CLEAR_INVERTED) {
+            // reset the other free bits of a shared clear as well, only the bit of this level is filled
             pattern.func = gfx::ComparisonFunc::NEVER;
             pattern.failOp = gfx::StencilOp::REPLACE;
-            pattern.writeMask = pattern.stencilMask = pattern.ref = getWriteMask();
+            pattern.writeMask = pattern.stencilMask = _clearBits;
+            pattern.ref = getWriteMask();
         } else if (stage == StencilStage::ENTER_LEVEL) {
             pattern.func = gfx::ComparisonFunc::NEVER;
             pattern.failOp = gfx::StencilOp::REPLACE;
@@ -158,6 +187,21 @@ void StencilManager::setDepthStencilStateFromStage(StencilStage stage) {
     }
 }
 
+uint64_t StencilManager::getStencilKey(const StencilEntity& pattern) {
+    return (pattern.stencilTest ? 1ULL : 0ULL) |
+           (static_cast<uint64_t>(pattern.func) << 1) |
+           (static_cast<uint64_t>(pattern.failOp) << 4) |
+           (static_cast<uint64_t>(pattern.stencilMask & STENCIL_BITS) << 7) |
+           (static_cast<uint64_t>(pattern.writeMask & STENCIL_BITS) << 15) |
+           (static_cast<uint64_t>(pattern.ref & STENCIL_BITS) << 23);
+}
+
+ccstd::hash_t StencilManager::getStencilHash(StencilStage stage) const {
+    StencilEntity pattern;
+    fillStencilPattern(stage, pattern);
+    return getStencilKey(pattern);
+}
+
 void StencilManager::setStencilStage(uint32_t stageIndex) {
     _stage = static_cast<StencilStage>(stageIndex);
 }
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <stack>
 #include "base/Macros.h"
 #include "base/TypeDef.h"
@@ -64,6 +65,9 @@ struct StencilEntity {
 
 class StencilManager final {
 public:
+    static constexpr uint32_t MAX_MASK_DEPTH = 8;
+    static constexpr uint32_t STENCIL_BITS = 0xff;
+
     static StencilManager* getInstance();
     StencilManager() = default;
     ~StencilManager();
@@ -76,10 +80,28 @@ public:
     inline uint32_t getMaskStackSize() const { return _maskStackSize; }
     inline void setMaskStackSize(uint32_t size) {
         _maskStackSize = size;
+        _stencilRef = 0;
+        for (uint32_t i = 0; i < _maskStackSize && i < MAX_MASK_DEPTH; i++) {
+            _maskBits[i] = 1 << i;
+            _stencilRef |= _maskBits[i];
+        }
+        // the content of the stencil buffer is unknown to the restored stack
+        _dirtyBits = STENCIL_BITS;
+        _clearBits = 0;
+    }
+
+    // Each level takes a stencil bit which is not used by its ancestors. Bits that are known to be zero are
+    // preferred, so only when all of them are dirty a single clear resets every free bit, which lets sibling
+    // masks at the same depth share one clear.
+    void pushMask();
+
+    // The stencil buffer content is unknown at the beginning of a root, e.g. cameras which don't clear stencil.
+    inline void resetDirtyBits() {
+        _dirtyBits = STENCIL_BITS;
     }
 
-    inline void pushMask() {
-        ++_maskStackSize;
+    inline bool needClear() const {
+        return _clearBits != 0;
     }
 
     StencilStage clear(RenderEntity* entity);
@@ -95,6 +117,9 @@ public:
         }
 
         --_maskStackSize;
+        if (_maskStackSize < MAX_MASK_DEPTH) {
+            _stencilRef &= ~_maskBits[_maskStackSize];
+        }
         if (_maskStackSize == 0) {
             _stage = StencilStage::DISABLED;
         } else {
@@ -103,24 +128,14 @@ public:
     }
 
     inline uint32_t getWriteMask() const {
-        return 1 << (_maskStackSize - 1);
-    }
-
-    inline uint32_t getExitWriteMask() const {
-        return 1 << _maskStackSize;
+        return _maskStackSize == 0 ? 0 : _maskBits[std::min(_maskStackSize, MAX_MASK_DEPTH) - 1];
     }
 
     inline uint32_t getStencilRef() const {
-        uint32_t result = 0;
-        for (uint32_t i = 0; i < _maskStackSize; i++) {
-            result += (1 << i);
-        }
-        return result;
+        return _stencilRef;
     }
 
-    inline uint32_t getStencilHash(StencilStage stage) const {
-        return ((static_cast<uint32_t>(stage)) << 8) | _maskStackSize;
-    }
+    ccstd::hash_t getStencilHash(StencilStage stage) const;
 
     void setStencilStage(uint32_t stageIndex);
 
@@ -133,8 +148,19 @@ private:
     StencilStage _stage{StencilStage::DISABLED};
 
     uint32_t _maskStackSize{0};
-
-    ccstd::unordered_map<uint32_t, gfx::DepthStencilState*> _cacheStateMap;
-    ccstd::unordered_map<uint32_t, gfx::DepthStencilState*> _cacheStateMapWithDepth;
+    // bit of each level, and all of them or-ed for the content test
+    uint32_t _maskBits[MAX_MASK_DEPTH]{};
+    uint32_t _stencilRef{0};
+    // bits which may be non zero in the stencil buffer
+    uint32_t _dirtyBits{STENCIL_BITS};
+    // bits the clear batch of the current level resets, 0 if the level doesn't need to clear
+    uint32_t _clearBits{0};
+
+    void fillStencilPattern(StencilStage stage, StencilEntity& pattern) const;
+    // stencil pattern in the low 31 bits, the depth state of the material above
+    static uint64_t getStencilKey(const StencilEntity& pattern);
+
+    ccstd::unordered_map<uint64_t, gfx::DepthStencilState*> _cacheStateMap;
+    ccstd::unordered_map<uint64_t, gfx::DepthStencilState*> _cacheStateMapWithDepth;
 };
 } // namespace cc
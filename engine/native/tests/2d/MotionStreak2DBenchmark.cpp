@@ -0,0 +1,204 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+// Parity checks and timings of MotionStreak2D, a standalone executable built from this file and MotionStreak2D.cpp
+// with the engine include directories.
+//
+// A port of MotionStreakAssembler.update keeps the points in an array as motion-streak-2d-assembler.ts does, the
+// streak must write the same vertices each frame while the node moves, stops and moves again. The long trail times
+// an update with thousands of living points. Exits with 1 if a check fails.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "2d/renderer/MotionStreak2D.h"
+#include "2d/renderer/RenderDrawInfo.h"
+#include "core/scene-graph/Node.h"
+
+using cc::MotionStreak2D;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) {
+        ++failures;
+    }
+}
+
+struct ScriptPoint {
+    float x{0.F};
+    float y{0.F};
+    float dirX{0.F};
+    float dirY{0.F};
+    float time{0.F};
+};
+
+// MotionStreakAssembler.update, the vertices of the frame in vData
+struct ScriptStreak {
+    std::vector<ScriptPoint> points;
+    std::vector<float> vData;
+    float fadeTime{1.F};
+    float minSeg{1.F};
+    float stroke{64.F};
+    cc::Color color;
+    float opacity{1.F};
+
+    void update(float tx, float ty, float dt) {
+        ScriptPoint* cur = nullptr;
+        if (points.size() > 1) {
+            const float difX = points[0].x - tx;
+            const float difY = points[0].y - ty;
+            if (difX * difX + difY * difY < minSeg) {
+                cur = &points[0];
+            }
+        }
+        if (cur == nullptr) {
+            points.insert(points.begin(), ScriptPoint{});
+            cur = &points[0];
+        }
+        cur->x = tx;
+        cur->y = ty;
+        cur->time = fadeTime + dt;
+        if (points.size() < 2) {
+            return;
+        }
+
+        ScriptPoint& prev = points[1];
+        float dirX = cur->x - prev.x;
+        float dirY = cur->y - prev.y;
+        float length = dirX * dirX + dirY * dirY;
+        if (length > 0.F) {
+            length = 1.F / std::sqrt(length);
+            dirX *= length;
+            dirY *= length;
+        }
+        prev.dirX = points[0].dirX = dirX;
+        prev.dirY = points[0].dirY = dirY;
+
+        const float halfStroke = stroke / 2.F;
+        const float alpha = opacity * color.a;
+        vData.clear();
+        bool findLast = false;
+        for (int i = static_cast<int>(points.size()) - 1; i >= 0; i--) {
+            ScriptPoint& p = points[i];
+            p.time -= dt;
+            if (p.time < 0.F) {
+                points.erase(points.begin() + i);
+                continue;
+            }
+            const float progress = p.time / fadeTime;
+            if (!findLast) {
+                if (i == 0) {
+                    points.erase(points.begin() + i);
+                    continue;
+                }
+                const ScriptPoint& next = points[i - 1];
+                p.x = next.x - p.dirX * progress;
+                p.y = next.y - p.dirY * progress;
+            }
+            findLast = true;
+            const float normalX = -p.dirY * halfStroke;
+            const float normalY = p.dirX * halfStroke;
+            // Color stores integers
+            const float a = static_cast<float>(static_cast<int>(progress * alpha)) / 255.F;
+            const float left[] = {p.x + normalX, p.y + normalY, 0.F, 1.F, progress, color.r / 255.F, color.g / 255.F, color.b / 255.F, a};
+            const float right[] = {p.x - normalX, p.y - normalY, 0.F, 0.F, progress, color.r / 255.F, color.g / 255.F, color.b / 255.F, a};
+            vData.insert(vData.end(), left, left + MotionStreak2D::VERTEX_STRIDE);
+            vData.insert(vData.end(), right, right + MotionStreak2D::VERTEX_STRIDE);
+        }
+    }
+};
+
+void checkScriptParity(cc::Node* node) {
+    const cc::Color color(200, 100, 50, 255);
+    MotionStreak2D streak;
+    cc::RenderDrawInfo drawInfo;
+    streak.setNode(node);
+    streak.setColor(color);
+    streak.setOpacity(0.5F);
+    streak.setDrawInfo(&drawInfo);
+    ScriptStreak script;
+    script.color = color;
+    script.opacity = 0.5F;
+
+    bool same = true;
+    bool drawInfoSame = true;
+    uint32_t seed = 1;
+    float x = 0.F;
+    float y = 0.F;
+    for (int frame = 0; frame < 3000 && same; frame++) {
+        seed = seed * 1664525 + 1013904223;
+        // stands still every third 200 frames, so the trail fades out completely
+        if ((frame / 200) % 3 != 2) {
+            x += static_cast<float>((seed >> 8) % 100) / 10.F - 3.F;
+            y += static_cast<float>((seed >> 16) % 100) / 20.F - 2.5F;
+        }
+        const float dt = 1.F / 60.F + static_cast<float>((seed >> 4) % 10) / 1000.F;
+        node->setPosition(x, y, 0.F);
+        streak.update(dt);
+        script.update(x, y, dt);
+
+        same = script.vData.size() == streak.getVertexCount() * MotionStreak2D::VERTEX_STRIDE;
+        for (size_t i = 0; same && i < script.vData.size(); i++) {
+            same = script.vData[i] == streak.getVData()[i];
+        }
+        drawInfoSame = drawInfoSame && drawInfo.getVDataBuffer() == streak.getVData() && drawInfo.getVbCount() == streak.getVertexCount() &&
+                       drawInfo.getIbCount() == streak.getIndexCount();
+    }
+    check(same, "streak writes the vertices of motion-streak-2d-assembler.ts each frame");
+    check(drawInfoSame, "draw info follows the strip");
+
+    streak.reset();
+    streak.update(1.F / 60.F);
+    check(drawInfo.getVbCount() == 0 && drawInfo.getIbCount() == 0, "the first point after reset draws nothing");
+}
+
+void benchmark(cc::Node* node) {
+    constexpr int FRAMES = 2000;
+    MotionStreak2D streak;
+    streak.setNode(node);
+    streak.setFadeTime(2.F);
+    streak.setMinSeg(0.F);
+    double time = 0.0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        node->setPosition(static_cast<float>(frame) * 3.F, std::sin(static_cast<float>(frame) * 0.1F) * 50.F, 0.F);
+        const auto start = std::chrono::steady_clock::now();
+        streak.update(1.F / 240.F);
+        time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::printf("long trail: %u points, %.2f us per update\n", streak.getPointCount(), time / FRAMES);
+}
+
+} // namespace
+
+int main() {
+    cc::Node node;
+    checkScriptParity(&node);
+    benchmark(&node);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/****************************************************************************
+ Copyright (c) 2019-2023 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos.com
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+****************************************************************************/
+
+// Parity checks and timings of ParticleSimulator2D and ParticleManager2D, a standalone executable built from this
+// file, ParticleSimulator2D.cpp, ParticleManager2D.cpp and Batcher2dWorkers.cpp with the engine include directories.
+//
+// Emitters stepped by the manager on worker threads must write the same vertices as the same emitters stepped one by
+// one, and a draw info must follow the vertex data when the config grows it. A visible frame is simulated in one step
+// while the time caught up on after a pause emits on each 1/30 s, paused emitters draw nothing and the budget holds
+// the total particles of the lower priorities. Exits with 1 if a check fails.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include "2d/renderer/Batcher2dWorkers.h"
+#include "2d/renderer/ParticleManager2D.h"
+#include "2d/renderer/RenderDrawInfo.h"
+#include "core/scene-graph/Node.h"
+
+using cc::ParticleEmitterConfig2D;
+using cc::ParticleManager2D;
+using cc::ParticleSimulator2D;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) {
+        ++failures;
+    }
+}
+
+ParticleEmitterConfig2D makeConfig(uint32_t index) {
+    ParticleEmitterConfig2D config;
+    config.totalParticles = 1000;
+    config.emissionRate = 2000.F;
+    config.life = 2.F;
+    config.lifeVar = 1.F;
+    config.startSpinVar = 90.F;
+    config.gravity = cc::Vec2(0.F, -100.F);
+    config.radialAccel = 10.F;
+    config.startColorVar = cc::Color(50, 50, 50, 0);
+    if (index % 3 == 0) {
+        config.emitterMode = cc::ParticleEmitterMode2D::RADIUS;
+        config.startRadius = 50.F;
+        config.endRadius = 200.F;
+        config.rotatePerS = 90.F;
+    }
+    if (index % 4 == 1) {
+        config.positionType = cc::ParticlePositionType2D::GROUPED;
+    }
+    return config;
+}
+
+void checkParallelSteps(cc::Node* node) {
+    constexpr uint32_t EMITTERS = 24;
+    constexpr int FRAMES = 600;
+    cc::Batcher2dWorkers workers(3);
+    auto* manager = ParticleManager2D::getInstance();
+    ParticleSimulator2D managed[EMITTERS];
+    ParticleSimulator2D serial[EMITTERS];
+    for (uint32_t i = 0; i < EMITTERS; i++) {
+        for (auto* simulator : {&managed[i], &serial[i]}) {
+            simulator->setConfig(makeConfig(i));
+            simulator->setNode(node);
+            simulator->setSeed(i + 1);
+            simulator->reset();
+        }
+        manager->addSimulator(&managed[i]);
+    }
+
+    double managedTime = 0.0;
+    double serialTime = 0.0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        const auto start = std::chrono::steady_clock::now();
+        manager->update(1.F / 60.F, &workers);
+        const auto middle = std::chrono::steady_clock::now();
+        for (auto& simulator : serial) {
+            simulator.step(1.F / 60.F);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        managedTime += std::chrono::duration<double, std::micro>(middle - start).count();
+        serialTime += std::chrono::duration<double, std::micro>(end - middle).count();
+    }
+
+    bool same = true;
+    for (uint32_t i = 0; i < EMITTERS; i++) {
+        const uint32_t count = managed[i].getParticleCount();
+        same = same && count == serial[i].getParticleCount() &&
+               std::memcmp(managed[i].getVData(), serial[i].getVData(), count * 4 * ParticleSimulator2D::VERTEX_STRIDE * sizeof(float)) == 0;
+    }
+    check(same, "emitters stepped on the workers match emitters stepped alone");
+    std::printf("%u particles: %.1f us per frame on %u workers, %.1f us stepped one by one\n", manager->getParticleCount(),
+                managedTime / FRAMES, workers.getThreadCount(), serialTime / FRAMES);
+    ParticleManager2D::destroyInstance();
+}
+
+void checkDrawInfoOnGrowth(cc::Node* node) {
+    ParticleSimulator2D simulator;
+    cc::RenderDrawInfo drawInfo;
+    ParticleEmitterConfig2D config = makeConfig(1);
+    config.totalParticles = 100;
+    simulator.setConfig(config);
+    simulator.setNode(node);
+    simulator.setDrawInfo(&drawInfo);
+    simulator.reset();
+    simulator.step(1.F / 60.F);
+    config.totalParticles = 4000;
+    simulator.setConfig(config);
+    check(drawInfo.getVDataBuffer() == simulator.getVData() && drawInfo.getIDataBuffer() == simulator.getIData() &&
+              drawInfo.getVbCount() == simulator.getParticleCount() * 4,
+          "draw info follows the vertex data grown by setConfig");
+}
+
+// a steady emitter fading out over its life, so the alpha of a particle tells its age
+ParticleEmitterConfig2D makeFadingConfig() {
+    ParticleEmitterConfig2D config;
+    config.totalParticles = 1000;
+    config.emissionRate = 30.F;
+    config.life = 2.F;
+    config.lifeVar = 0.F;
+    config.angleVar = 0.F;
+    config.speedVar = 0.F;
+    return config;
+}
+
+uint32_t countAges(const ParticleSimulator2D& simulator) {
+    std::set<float> alphas;
+    for (uint32_t i = 0; i < simulator.getParticleCount(); i++) {
+        alphas.insert(simulator.getVData()[i * 4 * ParticleSimulator2D::VERTEX_STRIDE + 8]);
+    }
+    return static_cast<uint32_t>(alphas.size());
+}
+
+void checkSubsteps(cc::Node* node) {
+    auto* manager = ParticleManager2D::getInstance();
+    ParticleSimulator2D visible;
+    ParticleSimulator2D paused;
+    for (auto* simulator : {&visible, &paused}) {
+        simulator->setConfig(makeFadingConfig());
+        simulator->setNode(node);
+        simulator->setCulling(cc::ParticleCulling2D::PAUSE);
+        simulator->reset();
+        manager->addSimulator(simulator);
+    }
+    paused.setCatchUp(true);
+    paused.setOpacity(0.F);
+    manager->update(0.2F, nullptr);
+    check(visible.getParticleCount() > 1 && countAges(visible) == 1, "a long visible frame is simulated in one step");
+
+    for (int frame = 0; frame < 59; frame++) {
+        manager->update(1.F / 60.F, nullptr);
+    }
+    check(paused.getParticleCount() == 0, "a paused emitter isn't simulated");
+    paused.setOpacity(1.F);
+    manager->update(1.F / 60.F, nullptr);
+    // a second caught up on, 30 substeps
+    check(countAges(paused) >= 25, "the time caught up on emits on each substep");
+    ParticleManager2D::destroyInstance();
+}
+
+void checkPausedDrawInfo(cc::Node* node) {
+    auto* manager = ParticleManager2D::getInstance();
+    ParticleSimulator2D simulator;
+    cc::RenderDrawInfo drawInfo;
+    simulator.setConfig(makeConfig(1));
+    simulator.setNode(node);
+    simulator.setDrawInfo(&drawInfo);
+    simulator.setCulling(cc::ParticleCulling2D::PAUSE);
+    simulator.reset();
+    manager->addSimulator(&simulator);
+    for (int frame = 0; frame < 30; frame++) {
+        manager->update(1.F / 60.F, nullptr);
+    }
+    const uint32_t count = simulator.getParticleCount();
+    simulator.setOpacity(0.F);
+    manager->update(1.F / 60.F, nullptr);
+    check(simulator.getParticleCount() == count && drawInfo.getVbCount() == 0 && drawInfo.getIbCount() == 0,
+          "a paused emitter keeps its particles and draws nothing");
+    simulator.setOpacity(1.F);
+    manager->update(1.F / 60.F, nullptr);
+    check(drawInfo.getVbCount() == simulator.getParticleCount() * 4 && drawInfo.getIbCount() == simulator.getParticleCount() * 6,
+          "a paused emitter draws again when visible");
+    ParticleManager2D::destroyInstance();
+}
+
+void checkBudget(cc::Node* node) {
+    constexpr uint32_t EMITTERS = 6;
+    constexpr uint32_t MAX_PARTICLES = 3000;
+    auto* manager = ParticleManager2D::getInstance();
+    ParticleSimulator2D simulators[EMITTERS];
+    for (uint32_t i = 0; i < EMITTERS; i++) {
+        ParticleEmitterConfig2D config = makeFadingConfig();
+        config.emissionRate = 500.F;
+        simulators[i].setConfig(config);
+        simulators[i].setNode(node);
+        simulators[i].setSeed(i + 1);
+        simulators[i].setPriority(i < 2 ? 10 : 0);
+        simulators[i].reset();
+        manager->addSimulator(&simulators[i]);
+    }
+    manager->setMaxParticles(MAX_PARTICLES);
+    for (int frame = 0; frame < 300; frame++) {
+        manager->update(1.F / 60.F, nullptr);
+    }
+    check(manager->getParticleCount() <= MAX_PARTICLES, "the budget holds the total particles");
+    check(simulators[0].getEmissionScale() == 1.F && simulators[0].getParticleCount() > 900 && simulators[EMITTERS - 1].getEmissionScale() < 1.F,
+          "the budget scales the lower priorities down first");
+    ParticleManager2D::destroyInstance();
+}
+
+} // namespace
+
+int main() {
+    cc::Node node;
+    checkParallelSteps(&node);
+    checkDrawInfoOnGrowth(&node);
+    checkSubsteps(&node);
+    checkPausedDrawInfo(&node);
+    checkBudget(&node);
+    return failures == 0 ? 0 : 1;
+}